@@ -0,0 +1,239 @@
+/*! \file   Arena.hpp
+ *  \brief  A scoped arena (monotonic buffer) for the digits of temporary BigIntegers.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * BigInteger2 and BigInteger3 allocate a new array of digits for nearly every operation,
+ * including every temporary created while evaluating an expression. In a tight loop the cost
+ * of all that memory management can exceed the cost of the arithmetic. An Arena makes those
+ * allocations nearly free. While an Arena object exists, digits are carved from large blocks
+ * owned by the arena by simply advancing a pointer, and freeing them does nothing. All of the
+ * memory is released at once when the arena is destroyed. For example:
+ *
+ *     for( ... ) {
+ *         vtsu::Arena arena( buffer, sizeof( buffer ) );
+ *         vtsu::BigInteger sum = a + b + c;
+ *         ...
+ *     }
+ *
+ * The arena takes memory from `buffer` first and only goes to the heap if that runs out, so a
+ * loop like this need not allocate any memory at all.
+ *
+ * Every BigInteger whose digits come from an arena must be destroyed before the arena is. A
+ * value that is needed after the arena is gone can be copied into an object declared outside
+ * the arena while an Arena::Pause is in effect. Moving such a value out of the arena is not
+ * allowed. Arenas are per-thread: an arena only affects the thread that created it, and values
+ * using an arena must not be given to other threads.
+ */
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace vtsu {
+
+    class Arena {
+    public:
+        //! Creates an arena and makes it the current arena of the calling thread.
+        /*!
+         * \param block_size The size of the first block taken from the heap. Each block is
+         * twice as large as the one before it, so the number of heap allocations is small.
+         */
+        explicit Arena( std::size_t block_size = 64 * 1024 );
+
+        //! Creates an arena that uses `buffer` before it uses the heap.
+        /*!
+         * The buffer is not released by the arena. It must remain available until the arena
+         * is destroyed.
+         */
+        Arena( void *buffer, std::size_t size );
+
+        //! Releases all memory taken from the heap and restores the previous arena (if any).
+        ~Arena( );
+
+        Arena( const Arena & ) = delete;
+        Arena &operator=( const Arena & ) = delete;
+
+        //! Returns `size` bytes of memory suitably aligned for any fundamental type.
+        void *allocate( std::size_t size );
+
+        //! Returns true if `p` points into memory that belongs to this arena.
+        bool owns( const void *p ) const;
+
+        //! Returns the total number of bytes handed out by allocate( ).
+        std::size_t bytes_allocated( ) const
+            { return total_allocated; }
+
+        //! Returns the arena used for allocations by the calling thread, or nullptr if none.
+        static Arena *current( )
+            { return active; }
+
+        //! Allocates an uninitialized array of `n` objects.
+        /*!
+         * The memory comes from the current arena if there is one and from new[] otherwise.
+         */
+        template<typename T>
+        static T *allocate_array( std::size_t n );
+
+        //! Frees an array obtained from allocate_array( ).
+        /*!
+         * Arrays that belong to an arena are left for the arena to release. This is true even
+         * if that arena is paused or isn't the innermost one.
+         */
+        template<typename T>
+        static void deallocate_array( T *p );
+
+        //! Suspends the current arena for the lifetime of a Pause object.
+        /*!
+         * While an arena is paused, new arrays come from the heap. This allows values computed
+         * in an arena to be copied into objects that outlive it.
+         */
+        class Pause {
+        public:
+            Pause( ) : saved( active ) { active = nullptr; }
+           ~Pause( ) { active = saved; }
+
+            Pause( const Pause & ) = delete;
+            Pause &operator=( const Pause & ) = delete;
+
+        private:
+            Arena *saved;
+        };
+
+    private:
+        // Each block begins with this header. The memory handed out follows it.
+        struct Block {
+            Block      *next;
+            std::size_t size;  // Number of bytes after the header.
+        };
+
+        static constexpr std::size_t alignment = alignof( std::max_align_t );
+        static constexpr std::size_t header_size =
+            ( sizeof( Block ) + alignment - 1 ) / alignment * alignment;
+
+        Block          *blocks = nullptr;   // Blocks from the heap, newest first.
+        unsigned char  *buffer_start;       // User supplied buffer (if any).
+        std::size_t     buffer_size;
+        unsigned char  *position;           // Next free byte in the newest block (or buffer).
+        std::size_t     remaining;          // Free bytes at `position`.
+        std::size_t     next_block_size;
+        std::size_t     total_allocated = 0;
+
+        Arena *previous_innermost;          // The arenas of this thread form a stack.
+        Arena *previous_active;
+
+        // The innermost arena (even if paused) and the arena currently used for allocations.
+        inline static thread_local Arena *innermost = nullptr;
+        inline static thread_local Arena *active    = nullptr;
+
+        static unsigned char *data( Block *block )
+            { return reinterpret_cast<unsigned char *>( block ) + header_size; }
+
+        void push( );
+    };
+
+
+    inline Arena::Arena( std::size_t block_size ) :
+        buffer_start{ nullptr }, buffer_size{ 0 }, position{ nullptr }, remaining{ 0 },
+        next_block_size{ std::max( block_size, alignment ) }
+    {
+        push( );
+    }
+
+
+    inline Arena::Arena( void *buffer, std::size_t size ) :
+        buffer_start{ static_cast<unsigned char *>( buffer ) }, buffer_size{ size },
+        position{ static_cast<unsigned char *>( buffer ) }, remaining{ size },
+        next_block_size{ std::max( size, std::size_t( 64 * 1024 ) ) }
+    {
+        push( );
+    }
+
+
+    inline Arena::~Arena( )
+    {
+        while( blocks != nullptr ) {
+            Block *next = blocks->next;
+            ::operator delete( blocks );
+            blocks = next;
+        }
+        innermost = previous_innermost;
+        active    = previous_active;
+    }
+
+
+    inline void Arena::push( )
+    {
+        previous_innermost = innermost;
+        previous_active    = active;
+        innermost = this;
+        active    = this;
+    }
+
+
+    inline void *Arena::allocate( std::size_t size )
+    {
+        // Round up so that the next allocation is also aligned. A user supplied buffer might
+        // not be aligned, so align the position itself too.
+        size = ( std::max( size, std::size_t( 1 ) ) + alignment - 1 ) / alignment * alignment;
+        void *p = position;
+        if( position == nullptr || std::align( alignment, size, p, remaining ) == nullptr ) {
+            // Start a new block. Oversized requests get a block of their own.
+            const std::size_t block_size = std::max( size, next_block_size );
+            Block *block = static_cast<Block *>( ::operator new( header_size + block_size ) );
+            block->next = blocks;
+            block->size = block_size;
+            blocks = block;
+            next_block_size = 2 * next_block_size;
+            p = data( block );
+            remaining = block_size;
+        }
+        position = static_cast<unsigned char *>( p ) + size;
+        remaining -= size;
+        total_allocated += size;
+        return p;
+    }
+
+
+    inline bool Arena::owns( const void *p ) const
+    {
+        // Pointer comparisons between unrelated objects are done with std::less (via the
+        // function object) since the built-in operators don't give a total order.
+        const auto inside = [p]( const unsigned char *start, std::size_t size ) {
+            std::less<const void *> less;
+            return !less( p, start ) && less( p, start + size );
+        };
+        if( buffer_start != nullptr && inside( buffer_start, buffer_size ) ) return true;
+        for( Block *block = blocks; block != nullptr; block = block->next ) {
+            if( inside( data( block ), block->size ) ) return true;
+        }
+        return false;
+    }
+
+
+    template<typename T>
+    T *Arena::allocate_array( std::size_t n )
+    {
+        static_assert( std::is_trivial_v<T>, "Arena arrays must hold trivial types" );
+        if( active == nullptr ) return new T[n];
+        return static_cast<T *>( active->allocate( n * sizeof( T ) ) );
+    }
+
+
+    template<typename T>
+    void Arena::deallocate_array( T *p )
+    {
+        for( Arena *arena = innermost; arena != nullptr; arena = arena->previous_innermost ) {
+            if( arena->owns( p ) ) return;
+        }
+        delete [] p;
+    }
+
+}
+
+#endif
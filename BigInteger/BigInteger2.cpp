@@ -7,6 +7,7 @@
 #include <iostream>
 #include <cctype>
 #include <cstring>
+#include "Arena.hpp"
 #include "BigInteger2.hpp"
 
 using namespace std;
@@ -32,7 +33,7 @@ namespace vtsu {
         }
         else {
             // Otherwise allocate space for a copy of the digits and then copy them.
-            digits = new unsigned short[other.digit_count];
+            digits = Arena::allocate_array<unsigned short>( other.digit_count );
             std::memcpy( digits, other.digits, digit_count * sizeof( unsigned short ) );
         }
     }
@@ -46,7 +47,7 @@ namespace vtsu {
             // Next, get rid of the digits array we are currently managing.
             // This is not exception safe.
             // TODO: Fix the exception safety issue!
-            delete [] digits;
+            Arena::deallocate_array( digits );
 
             // Finally do what is essentially the same logic as the copy constructor. Notice
             // that the copy assignment operator has extra work and so is, in general, slower.
@@ -58,7 +59,7 @@ namespace vtsu {
                 digits = nullptr;
             }
             else {
-                digits = new unsigned short[other.digit_count];
+                digits = Arena::allocate_array<unsigned short>( other.digit_count );
                 std::memcpy( digits, other.digits, digit_count * sizeof( unsigned short ) );
             }
         }
@@ -68,7 +69,7 @@ namespace vtsu {
 
     BigInteger::~BigInteger( )
     {
-        delete [] digits;
+        Arena::deallocate_array( digits );
     }
 
 
@@ -128,7 +129,7 @@ namespace vtsu {
             digit_count = right.digit_count;
             // This check is needed to deal with 0 += 0.
             if( digit_count != 0 ) {
-                digits = new unsigned short[digit_count];
+                digits = Arena::allocate_array<unsigned short>( digit_count );
                 std::memcpy( digits, right.digits, digit_count * sizeof( unsigned short ) );
             }
             return *this;
@@ -197,7 +198,7 @@ namespace vtsu {
     {
         // Expanding zero entails adding a single digit.
         if( digits == nullptr ) {
-            digits = new unsigned short[1];
+            digits = Arena::allocate_array<unsigned short>( 1 );
             digits[0] = 0;
         }
         else {
@@ -207,10 +208,10 @@ namespace vtsu {
             // block size increases each time the array is reallocated. That would require
             // keeping track of both the size of the array and the number of "actual" digits it
             // contains.
-            unsigned short *new_digits = new unsigned short[digit_count + 1];
+            unsigned short *new_digits = Arena::allocate_array<unsigned short>( digit_count + 1 );
             std::memcpy( new_digits, digits, digit_count * sizeof( unsigned short ) );
             new_digits[digit_count] = 0;
-            delete [] digits;
+            Arena::deallocate_array( digits );
             digits = new_digits;
         }
         digit_count++;
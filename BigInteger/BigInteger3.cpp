@@ -8,6 +8,7 @@
 #include <cstring>
 #include <iostream>
 #include <limits>    // For std::numeric_limits
+#include "Arena.hpp"
 #include "BigInteger3.hpp"
 
 using namespace std;
@@ -33,7 +34,7 @@ namespace vtsu {
         }
         else {
             // Otherwise allocate space for a copy of the digits and then copy them.
-            digits = new storage_type[other.digit_count];
+            digits = Arena::allocate_array<storage_type>( other.digit_count );
             std::memcpy( digits, other.digits, digit_count * sizeof( storage_type ) );
         }
     }
@@ -45,15 +46,15 @@ namespace vtsu {
         if( this != &other ) {
 
             if( other.digit_count == 0 ) {
-                delete [] digits;
+                Arena::deallocate_array( digits );
                 digits = nullptr;
                 digit_count = other.digit_count;
             }
             else {
                 // This is exception safe. Allocate storage *before* deleting our value.
-                storage_type *temp = new storage_type[other.digit_count];
-                std::memcpy( digits, other.digits, digit_count * sizeof( storage_type ) );
-                delete [] digits;
+                storage_type *temp = Arena::allocate_array<storage_type>( other.digit_count );
+                std::memcpy( temp, other.digits, other.digit_count * sizeof( storage_type ) );
+                Arena::deallocate_array( digits );
                 digits = temp;
                 digit_count = other.digit_count;
             }
@@ -99,7 +100,7 @@ namespace vtsu {
             // Next, get rid of the digits array we are currently managing. This is exception
             // safe because none of the operations done after this can possibly throw an
             // exception.
-            delete [] digits;
+            Arena::deallocate_array( digits );
 
             // Move the other value into ourselves.
             digit_count = other.digit_count;
@@ -115,7 +116,7 @@ namespace vtsu {
 
     BigInteger::~BigInteger( )
     {
-        delete [] digits;
+        Arena::deallocate_array( digits );
     }
 
 
@@ -179,7 +180,7 @@ namespace vtsu {
         if( digit_count == 0 ) {
             digit_count = right.digit_count;
             if( digit_count != 0 ) {
-                digits = new storage_type[digit_count];
+                digits = Arena::allocate_array<storage_type>( digit_count );
                 std::memcpy( digits, right.digits, digit_count * sizeof( storage_type ) );
             }
             return *this;
@@ -231,7 +232,46 @@ namespace vtsu {
 
     BigInteger &BigInteger::operator*=( const BigInteger &right )
     {
-        // TODO: Finish Me!
+        // Multiplying by zero produces zero, which is represented in a special way.
+        if( digit_count == 0 || right.digit_count == 0 ) {
+            Arena::deallocate_array( digits );
+            digits = nullptr;
+            digit_count = 0;
+            return *this;
+        }
+
+        const compute_type digit_modulus =
+            static_cast<compute_type>( numeric_limits<storage_type>::max( ) ) + 1;
+
+        // This is the usual "grade school" algorithm. The product is built in a new array since
+        // the digits of both operands are needed until the end. This also makes `x *= x` work.
+        // Note that the largest possible value of `temp` is (digit_modulus - 1)**2 plus two
+        // digits, which still fits in compute_type.
+        size_t product_count = digit_count + right.digit_count;
+        storage_type *product = Arena::allocate_array<storage_type>( product_count );
+        std::fill( product, product + product_count, storage_type( 0 ) );
+        for( size_t i = 0; i < digit_count; ++i ) {
+            compute_type carry = 0;
+            for( size_t j = 0; j < right.digit_count; ++j ) {
+                compute_type temp =
+                    static_cast<compute_type>( digits[i] ) * right.digits[j] + product[i + j] + carry;
+                product[i + j] = static_cast<storage_type>( temp % digit_modulus );
+                carry = temp / digit_modulus;
+            }
+            product[i + right.digit_count] = static_cast<storage_type>( carry );
+        }
+
+        // The product might have one leading zero. Remove it to maintain the invariant.
+        if( product[product_count - 1] == 0 ) {
+            --product_count;
+            storage_type *trimmed = Arena::allocate_array<storage_type>( product_count );
+            std::memcpy( trimmed, product, product_count * sizeof( storage_type ) );
+            Arena::deallocate_array( product );
+            product = trimmed;
+        }
+        Arena::deallocate_array( digits );
+        digits = product;
+        digit_count = product_count;
         return *this;
     }
 
@@ -243,14 +283,12 @@ namespace vtsu {
         // Handle the special case of zero.
         if( digit_count == 0 ) return value;
 
-        size_t digit_index = digit_count - 1;
-
         const compute_type digit_modulus =
             static_cast<compute_type>( numeric_limits<storage_type>::max( ) ) + 1;
 
-        while( digit_index >= 0 ) {
+        // The index is unsigned so it can't be tested for >= 0. Decrement it before use instead.
+        for( size_t digit_index = digit_count; digit_index-- > 0; ) {
             value = ( digit_modulus * value ) + digits[digit_index];
-            digit_index--;
         }
         // TODO: Add overflow check. We should probably throw an exception.
         return value;
@@ -266,7 +304,7 @@ namespace vtsu {
     {
         // Expanding zero entails adding a single digit.
         if( digits == nullptr ) {
-            digits = new storage_type[1];
+            digits = Arena::allocate_array<storage_type>( 1 );
             digits[0] = 0;
         }
         else {
@@ -276,10 +314,10 @@ namespace vtsu {
             // block size increases each time the array is reallocated. That would require
             // keeping track of both the size of the array and the number of "actual" digits it
             // contains.
-            storage_type *new_digits = new storage_type[digit_count + 1];
+            storage_type *new_digits = Arena::allocate_array<storage_type>( digit_count + 1 );
             std::memcpy( new_digits, digits, digit_count * sizeof( storage_type ) );
             new_digits[digit_count] = 0;
-            delete []  digits;
+            Arena::deallocate_array( digits );
             digits = new_digits;
         }
         digit_count++;
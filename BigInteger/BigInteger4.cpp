@@ -1,161 +1,1886 @@
+/*! \file   BigInteger4.cpp
+ *  \brief  A "fourth generation" definition of an extended precision integer class.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ */
 
 #include <algorithm>
+#include <bit>
+#include <compare>
 #include <iostream>
 #include <cctype>
 #include <cstring>
 #include <limits>
+#include <type_traits>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "BigInteger4.hpp"
+#include "../Thread/ThreadPool.hpp"
+
+// The carry propagation and wide multiplication kernels use compiler intrinsics where they are
+// available. Define BIGINTEGER_PORTABLE to use only standard C++ instead (mostly for testing).
+#if !defined( BIGINTEGER_PORTABLE )
+    #if defined( _MSC_VER ) && defined( _M_X64 )
+        #include <intrin.h>
+        #define BIGINTEGER_X64_INTRINSICS
+        #define BIGINTEGER_MSVC_WIDE
+    #elif ( defined( __GNUC__ ) || defined( __clang__ ) ) && defined( __x86_64__ )
+        #include <x86intrin.h>
+        #define BIGINTEGER_X64_INTRINSICS
+    #endif
+    #if defined( __SIZEOF_INT128__ )
+        #define BIGINTEGER_INT128
+    #endif
+#endif
 
 using namespace std;
 
 namespace vtsu {
 
-    BigInteger::BigInteger( unsigned long value )
-    {
-        static_assert( numeric_limits<unsigned long>::max( ) > numeric_limits<storage_type>::max( ) );
-        const unsigned long digit_modulus =
-            static_cast<unsigned long>( numeric_limits<storage_type>::max( ) ) + 1;
+    namespace {
+
+        // Low Level Limb Operations
+        // =========================
+        //
+        // The functions in this section operate on raw arrays of digits (called "limbs" here to
+        // avoid confusion with decimal digits). As with the `digits` member of BigInteger, the
+        // least significant limb is stored first. These functions don't know anything about
+        // BigInteger objects, which makes it easy for the higher level algorithms to apply them
+        // to parts of numbers. The limb type must be the same as BigInteger::storage_type.
+
+        using limb_type = std::uint64_t;
+
+        constexpr int limb_bits = numeric_limits<limb_type>::digits;
+
+        // Temporary values use the same container as BigInteger so that intermediate results
+        // can be moved into (and out of) BigInteger objects, and so that small temporaries
+        // don't allocate memory either.
+        constexpr size_t inline_limbs = 128 / limb_bits;
+        using limb_vector = SmallVector<limb_type, inline_limbs>;
+
+        // Karatsuba multiplication is only used when both operands have at least this many
+        // limbs. Below this size the simple "schoolbook" method is faster.
+        constexpr size_t karatsuba_threshold = 32;
+
+        // Karatsuba multiplications of at least this many limbs compute their three
+        // sub-products in parallel. Smaller products aren't worth the overhead.
+        constexpr size_t parallel_threshold = 512;
+
+        // Multiplication using a number theoretic transform is used when both operands have at
+        // least this many limbs. The transform can handle products up to ntt_max_limbs limbs.
+        constexpr size_t ntt_threshold = 24 * 1024;
+        constexpr size_t ntt_max_limbs = static_cast<size_t>( 1 ) << 28;
+
+        // Division by Newton's method is only used when both the divisor and the quotient have
+        // at least this many limbs. Below this size Knuth's Algorithm D is faster.
+        constexpr size_t newton_threshold = 128;
+
+        // Modular exponentiation uses Montgomery reduction for odd moduli with fewer limbs than
+        // this. Larger (and all even) moduli use Barrett reduction, which benefits from fast
+        // multiplication.
+        constexpr size_t montgomery_threshold = 128;
+
+        // Decimal conversions work with "chunks" of nineteen decimal digits. A chunk fits in a
+        // single limb, so converting a chunk to or from binary is cheap. Every chunk holds more
+        // than chunk_bits bits.
+        constexpr size_t    chunk_digits = 19;
+        constexpr limb_type chunk_base   = 10'000'000'000'000'000'000U;
+        constexpr int       chunk_bits   = bit_width( chunk_base ) - 1;
+
+        // Decimal conversions on fewer chunks than this use the simple quadratic methods.
+        constexpr size_t conversion_threshold = 32;
+
+
+        // Single Limb Arithmetic
+        // ======================
+        //
+        // These functions provide the operations on single limbs that C++ doesn't: addition
+        // and subtraction with a carry (or borrow) in and out, and multiplication and division
+        // using a double width intermediate. Where possible they map directly to machine
+        // instructions (an adc chain for addition, for example). The portable versions are
+        // written without branches so that the loops using them run at a steady pace.
+
+        // Returns a + b + carry and sets carry to the carry out. The carry must be 0 or 1.
+        inline limb_type add_carry( limb_type a, limb_type b, unsigned char &carry )
+        {
+        #if defined( BIGINTEGER_X64_INTRINSICS )
+            unsigned long long sum;
+            carry = _addcarry_u64( carry, a, b, &sum );
+            return sum;
+        #else
+            const limb_type partial = a + b;
+            const limb_type sum = partial + carry;
+            carry = static_cast<unsigned char>( ( partial < a ) | ( sum < partial ) );
+            return sum;
+        #endif
+        }
+
+
+        // Returns a - b - borrow and sets borrow to the borrow out. The borrow must be 0 or 1.
+        inline limb_type sub_borrow( limb_type a, limb_type b, unsigned char &borrow )
+        {
+        #if defined( BIGINTEGER_X64_INTRINSICS )
+            unsigned long long difference;
+            borrow = _subborrow_u64( borrow, a, b, &difference );
+            return difference;
+        #else
+            const limb_type partial = a - b;
+            const limb_type difference = partial - borrow;
+            borrow = static_cast<unsigned char>( ( a < b ) | ( partial < borrow ) );
+            return difference;
+        #endif
+        }
+
+
+        // Returns the low limb of a * b and sets high to the high limb.
+        inline limb_type multiply_wide( limb_type a, limb_type b, limb_type &high )
+        {
+        #if defined( BIGINTEGER_INT128 )
+            const unsigned __int128 product = static_cast<unsigned __int128>( a ) * b;
+            high = static_cast<limb_type>( product >> limb_bits );
+            return static_cast<limb_type>( product );
+        #elif defined( BIGINTEGER_MSVC_WIDE )
+            unsigned long long product_high;
+            const limb_type low = _umul128( a, b, &product_high );
+            high = product_high;
+            return low;
+        #else
+            // Multiply the half limbs separately as in the schoolbook method.
+            constexpr int half_bits = limb_bits / 2;
+            constexpr limb_type half_mask = ( static_cast<limb_type>( 1 ) << half_bits ) - 1;
+            const limb_type a_low = a & half_mask, a_high = a >> half_bits;
+            const limb_type b_low = b & half_mask, b_high = b >> half_bits;
+
+            const limb_type low_low   = a_low  * b_low;
+            const limb_type low_high  = a_low  * b_high;
+            const limb_type high_low  = a_high * b_low;
+            const limb_type high_high = a_high * b_high;
+
+            // None of these sums can overflow.
+            const limb_type middle = ( low_low >> half_bits ) + ( low_high & half_mask ) + ( high_low & half_mask );
+            high = high_high + ( low_high >> half_bits ) + ( high_low >> half_bits ) + ( middle >> half_bits );
+            return ( middle << half_bits ) | ( low_low & half_mask );
+        #endif
+        }
+
+
+        // Returns ( high*B + low ) / d and sets remainder to ( high*B + low ) % d, where B is
+        // 2**limb_bits. Requires high < d so that the quotient fits in one limb.
+        inline limb_type divide_wide( limb_type high, limb_type low, limb_type d, limb_type &remainder )
+        {
+        #if defined( BIGINTEGER_INT128 )
+            const unsigned __int128 numerator = ( static_cast<unsigned __int128>( high ) << limb_bits ) | low;
+            remainder = static_cast<limb_type>( numerator % d );
+            return static_cast<limb_type>( numerator / d );
+        #elif defined( BIGINTEGER_MSVC_WIDE )
+            unsigned long long rest;
+            const limb_type quotient = _udiv128( high, low, d, &rest );
+            remainder = rest;
+            return quotient;
+        #else
+            // Divide using half limbs as digits. This is Algorithm D (see divmod_knuth( )) for
+            // a four digit dividend and a two digit divisor. See also "Hacker's Delight" by
+            // Henry S. Warren, section 9-4.
+            constexpr int half_bits = limb_bits / 2;
+            constexpr limb_type half_base = static_cast<limb_type>( 1 ) << half_bits;
+            constexpr limb_type half_mask = half_base - 1;
+
+            // Normalize so the top bit of the divisor is set.
+            const int shift = countl_zero( d );
+            d <<= shift;
+            const limb_type d_high = d >> half_bits;
+            const limb_type d_low  = d & half_mask;
+            const limb_type n_top  = ( shift == 0 ) ? high : ( high << shift ) | ( low >> ( limb_bits - shift ) );
+            const limb_type n_rest = low << shift;
+            const limb_type n_1 = n_rest >> half_bits;
+            const limb_type n_0 = n_rest & half_mask;
+
+            limb_type q_1 = n_top / d_high;
+            limb_type r_hat = n_top - q_1 * d_high;
+            while( q_1 >= half_base || q_1 * d_low > ( r_hat << half_bits ) + n_1 ) {
+                --q_1;
+                r_hat += d_high;
+                if( r_hat >= half_base ) break;
+            }
+
+            const limb_type middle = ( n_top << half_bits ) + n_1 - q_1 * d;
+            limb_type q_0 = middle / d_high;
+            r_hat = middle - q_0 * d_high;
+            while( q_0 >= half_base || q_0 * d_low > ( r_hat << half_bits ) + n_0 ) {
+                --q_0;
+                r_hat += d_high;
+                if( r_hat >= half_base ) break;
+            }
+
+            remainder = ( ( middle << half_bits ) + n_0 - q_0 * d ) >> shift;
+            return ( q_1 << half_bits ) + q_0;
+        #endif
+        }
+
+
+        // Removes leading zero limbs (stored at the end of the vector).
+        void normalize( limb_vector &value )
+        {
+            while( !value.empty( ) && value.back( ) == 0 ) value.pop_back( );
+        }
+
+
+        // Returns the number of limbs in a[0 .. n) that remain after leading zeros are removed.
+        size_t significant_size( const limb_type *a, size_t n )
+        {
+            while( n > 0 && a[n - 1] == 0 ) --n;
+            return n;
+        }
+
+
+        // Compares a[0 .. n) with b[0 .. n). Leading zeros are allowed.
+        int compare_n( const limb_type *a, const limb_type *b, size_t n )
+        {
+            for( size_t i = n; i-- > 0; ) {
+                if( a[i] != b[i] ) return ( a[i] < b[i] ) ? -1 : 1;
+            }
+            return 0;
+        }
+
+
+        // Compares a[0 .. an) with b[0 .. bn). Both arrays must be free of leading zeros.
+        // Returns a negative, zero, or positive value in the same manner as std::memcmp.
+        int compare( const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            if( an != bn ) return ( an < bn ) ? -1 : 1;
+            for( size_t i = an; i-- > 0; ) {
+                if( a[i] != b[i] ) return ( a[i] < b[i] ) ? -1 : 1;
+            }
+            return 0;
+        }
+
+
+        // r[0 .. n) = a[0 .. n) + b[0 .. n). Returns the carry out. The arrays may overlap
+        // provided that r starts at the same place as a or b. The loop is unrolled so the
+        // carry flows from one limb to the next with little loop overhead.
+        limb_type add_n( limb_type *r, const limb_type *a, const limb_type *b, size_t n )
+        {
+            unsigned char carry = 0;
+            size_t i = 0;
+            for( ; i + 4 <= n; i += 4 ) {
+                r[i    ] = add_carry( a[i    ], b[i    ], carry );
+                r[i + 1] = add_carry( a[i + 1], b[i + 1], carry );
+                r[i + 2] = add_carry( a[i + 2], b[i + 2], carry );
+                r[i + 3] = add_carry( a[i + 3], b[i + 3], carry );
+            }
+            for( ; i < n; ++i ) {
+                r[i] = add_carry( a[i], b[i], carry );
+            }
+            return carry;
+        }
+
+
+        // r[0 .. n) = a[0 .. n) + b. Returns the carry out. The loop stops as soon as the carry
+        // dies out, so adding into the low end of a long number in place is cheap.
+        limb_type add_1( limb_type *r, const limb_type *a, size_t n, limb_type b )
+        {
+            limb_type carry = b;
+            size_t i = 0;
+            for( ; i < n && carry != 0; ++i ) {
+                r[i]  = a[i] + carry;
+                carry = ( r[i] < carry ) ? 1 : 0;
+            }
+            if( r != a ) std::copy( a + i, a + n, r + i );
+            return carry;
+        }
+
+
+        // r[0 .. an) = a[0 .. an) + b[0 .. bn). Requires an >= bn. Returns the carry out.
+        limb_type add( limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            limb_type carry = add_n( r, a, b, bn );
+            return add_1( r + bn, a + bn, an - bn, carry );
+        }
+
+
+        // r[0 .. n) = a[0 .. n) - b[0 .. n). Returns the borrow out. The same overlap rules as
+        // for add_n( ) apply.
+        limb_type sub_n( limb_type *r, const limb_type *a, const limb_type *b, size_t n )
+        {
+            unsigned char borrow = 0;
+            size_t i = 0;
+            for( ; i + 4 <= n; i += 4 ) {
+                r[i    ] = sub_borrow( a[i    ], b[i    ], borrow );
+                r[i + 1] = sub_borrow( a[i + 1], b[i + 1], borrow );
+                r[i + 2] = sub_borrow( a[i + 2], b[i + 2], borrow );
+                r[i + 3] = sub_borrow( a[i + 3], b[i + 3], borrow );
+            }
+            for( ; i < n; ++i ) {
+                r[i] = sub_borrow( a[i], b[i], borrow );
+            }
+            return borrow;
+        }
+
+
+        // r[0 .. n) = a[0 .. n) - b. Returns the borrow out. As with add_1( ), the loop stops as
+        // soon as the borrow dies out.
+        limb_type sub_1( limb_type *r, const limb_type *a, size_t n, limb_type b )
+        {
+            limb_type borrow = b;
+            size_t i = 0;
+            for( ; i < n && borrow != 0; ++i ) {
+                limb_type x = a[i];
+                r[i]   = x - borrow;
+                borrow = ( x < borrow ) ? 1 : 0;
+            }
+            if( r != a ) std::copy( a + i, a + n, r + i );
+            return borrow;
+        }
+
+
+        // r[0 .. an) = a[0 .. an) - b[0 .. bn). Requires an >= bn. Returns the borrow out.
+        limb_type sub( limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            limb_type borrow = sub_n( r, a, b, bn );
+            return sub_1( r + bn, a + bn, an - bn, borrow );
+        }
+
+
+        // r[0 .. n) = a[0 .. n) * b. Returns the carry out. The arrays r and a may be the same.
+        limb_type mul_1( limb_type *r, const limb_type *a, size_t n, limb_type b )
+        {
+            limb_type carry = 0;
+            for( size_t i = 0; i < n; ++i ) {
+                limb_type high;
+                const limb_type low = multiply_wide( a[i], b, high );
+                unsigned char c = 0;
+                r[i]  = add_carry( low, carry, c );
+                carry = high + c;
+            }
+            return carry;
+        }
+
+
+        // r[0 .. n) += a[0 .. n) * b. Returns the carry out. The maximum value of the product
+        // plus two limbs is exactly the maximum value of a double limb so nothing overflows.
+        limb_type addmul_1( limb_type *r, const limb_type *a, size_t n, limb_type b )
+        {
+            limb_type carry = 0;
+            for( size_t i = 0; i < n; ++i ) {
+                limb_type high;
+                const limb_type low = multiply_wide( a[i], b, high );
+                unsigned char c1 = 0;
+                unsigned char c2 = 0;
+                const limb_type sum = add_carry( low, carry, c1 );
+                r[i]  = add_carry( r[i], sum, c2 );
+                carry = high + c1 + c2;
+            }
+            return carry;
+        }
+
+
+        // r[0 .. n) -= a[0 .. n) * b. Returns the borrow out.
+        limb_type submul_1( limb_type *r, const limb_type *a, size_t n, limb_type b )
+        {
+            limb_type carry = 0;
+            for( size_t i = 0; i < n; ++i ) {
+                limb_type high;
+                const limb_type low = multiply_wide( a[i], b, high );
+                unsigned char c = 0;
+                unsigned char borrow = 0;
+                const limb_type subtrahend = add_carry( low, carry, c );
+                r[i]  = sub_borrow( r[i], subtrahend, borrow );
+                carry = high + c + borrow;
+            }
+            return carry;
+        }
+
+
+        // r[0 .. n) = a[0 .. n) << shift. Requires 0 <= shift < limb_bits. Returns the bits
+        // shifted out of the top limb.
+        limb_type shift_left( limb_type *r, const limb_type *a, size_t n, int shift )
+        {
+            if( shift == 0 ) {
+                std::copy( a, a + n, r );
+                return 0;
+            }
+            limb_type carry = 0;
+            for( size_t i = 0; i < n; ++i ) {
+                limb_type x = a[i];
+                r[i]  = ( x << shift ) | carry;
+                carry = x >> ( limb_bits - shift );
+            }
+            return carry;
+        }
+
+
+        // r[0 .. n) = a[0 .. n) >> shift. Requires 0 <= shift < limb_bits.
+        void shift_right( limb_type *r, const limb_type *a, size_t n, int shift )
+        {
+            if( shift == 0 ) {
+                std::copy( a, a + n, r );
+                return;
+            }
+            for( size_t i = 0; i < n; ++i ) {
+                limb_type high = ( i + 1 < n ) ? a[i + 1] << ( limb_bits - shift ) : 0;
+                r[i] = ( a[i] >> shift ) | high;
+            }
+        }
+
+
+        // Multiplication
+        // ==============
+
+        // r[0 .. an + bn) = a[0 .. an) * b[0 .. bn). Requires bn >= 1. The array r must not
+        // overlap either a or b.
+        void mul_basecase( limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            r[an] = mul_1( r, a, an, b[0] );
+            for( size_t j = 1; j < bn; ++j ) {
+                r[an + j] = addmul_1( r + j, a, an, b[j] );
+            }
+        }
+
+
+        // Returns a pool that, together with the calling thread, provides `thread_count`
+        // threads. There is no pool (and everything runs in the calling thread) for a thread
+        // count of zero or one.
+        unique_ptr<ThreadPool> make_multiplication_pool( unsigned thread_count )
+        {
+            if( thread_count <= 1 ) return nullptr;
+            return make_unique<ThreadPool>( thread_count - 1 );
+        }
+
+        // The pool of threads used by multiplication. It is created when first needed (which is
+        // thread safe since it is a static local) and replaced by set_multiplication_threads( ).
+        unique_ptr<ThreadPool> &multiplication_pool_pointer( )
+        {
+            static unique_ptr<ThreadPool> pool = make_multiplication_pool( thread::hardware_concurrency( ) );
+            return pool;
+        }
+
+        // Runs the functions, in parallel if there is a pool, and returns when all of them are
+        // finished. Each function is one iteration of a parallel_for( ), which runs other tasks
+        // while it waits, so the functions can call run_in_parallel( ) themselves.
+        template<typename... Functions>
+        void run_in_parallel( Functions &... functions )
+        {
+            ThreadPool *pool = multiplication_pool_pointer( ).get( );
+            if( pool == nullptr ) {
+                ( functions( ), ... );
+                return;
+            }
+            pool->parallel_for( size_t( 0 ), sizeof...( Functions ), [&]( size_t index ) {
+                size_t position = 0;
+                ( ( position++ == index ? functions( ) : void( ) ), ... );
+            }, 1 );
+        }
+
+
+        // Number Theoretic Transform
+        // --------------------------
+        //
+        // Very large products are computed by treating the operands as polynomials, evaluating
+        // them at the powers of a root of unity (the transform), multiplying the values point by
+        // point, and interpolating (the inverse transform) to get the coefficients of the
+        // product. The transform takes O(n log n) time so the whole multiplication does too.
+        //
+        // The arithmetic is done modulo the prime p = 2**64 - 2**32 + 1, which has roots of
+        // unity of every power of two order up to 2**32. Each limb is split into four 16 bit
+        // coefficients. Each coefficient of the product is then less than size * 2**32, which is
+        // less than p for every size that is used. Thus the coefficients are exact and carrying
+        // them into limbs gives the product.
+
+        constexpr limb_type ntt_prime = 0xFFFF'FFFF'0000'0001;
+        constexpr limb_type ntt_generator = 7;  // A primitive root modulo ntt_prime.
+        constexpr int       ntt_coefficient_bits = 16;
+        constexpr size_t    ntt_coefficients_per_limb = limb_bits / ntt_coefficient_bits;
+
+        // Transforms of at least this size split into parallel tasks.
+        constexpr size_t ntt_parallel_threshold = 1 << 14;
+
+        // The values being transformed are essentially random, so the conditional corrections
+        // in these functions are done with masks rather than branches, which would be
+        // mispredicted half the time.
+
+        // Returns all one bits if `condition` is true and zero otherwise.
+        inline limb_type mask_if( bool condition )
+        {
+            return static_cast<limb_type>( 0 ) - static_cast<limb_type>( condition );
+        }
+
+        inline limb_type ntt_add( limb_type a, limb_type b )
+        {
+            const limb_type sum = a + b;
+            // If the sum overflowed, subtracting p (mod 2**64) also gives the right answer.
+            return sum - ( ntt_prime & mask_if( ( sum < a ) | ( sum >= ntt_prime ) ) );
+        }
+
+        inline limb_type ntt_sub( limb_type a, limb_type b )
+        {
+            return a - b + ( ntt_prime & mask_if( a < b ) );
+        }
 
-        while( value > 0UL ) {
-            digits.push_back( static_cast<unsigned short>( value % digit_modulus ) );
-            value = value / digit_modulus;
+        inline limb_type ntt_multiply( limb_type a, limb_type b )
+        {
+            // Reduce high*2**64 + low using 2**64 == 2**32 - 1 and 2**96 == -1 (mod p).
+            constexpr limb_type epsilon = 0xFFFF'FFFF;  // 2**64 mod p.
+            limb_type high;
+            const limb_type low = multiply_wide( a, b, high );
+            const limb_type high_high = high >> 32;
+            const limb_type high_low  = high & epsilon;
+
+            const limb_type t = low - high_high - ( epsilon & mask_if( low < high_high ) );
+            const limb_type u = high_low * epsilon;
+            limb_type result = t + u;
+            result += epsilon & mask_if( result < u );
+            return result - ( ntt_prime & mask_if( result >= ntt_prime ) );
+        }
+
+        limb_type ntt_power( limb_type base, limb_type exponent )
+        {
+            limb_type result = 1;
+            while( exponent != 0 ) {
+                if( exponent & 1 ) result = ntt_multiply( result, base );
+                base = ntt_multiply( base, base );
+                exponent >>= 1;
+            }
+            return result;
+        }
+
+
+        // Returns a table of roots of unity for transforms of size n (a power of two). For each
+        // power of two m <= n, table[m/2 + i] = w**i for 0 <= i < m/2, where w is a primitive
+        // m-th root of unity (or its inverse if `inverse` is true).
+        limb_vector ntt_roots( size_t n, bool inverse )
+        {
+            limb_vector table( n );
+            if( n < 2 ) return table;
+            limb_type w = ntt_power( ntt_generator, ( ntt_prime - 1 ) / n );
+            if( inverse ) w = ntt_power( w, ntt_prime - 2 );
+
+            table[n / 2] = 1;
+            for( size_t i = n / 2 + 1; i < n; ++i ) {
+                table[i] = ntt_multiply( table[i - 1], w );
+            }
+            // The m-th roots are every other (2m)-th root.
+            for( size_t i = n / 2; i-- > 1; ) {
+                table[i] = table[2 * i];
+            }
+            return table;
+        }
+
+
+        // Transforms a[0 .. n) in place using decimation in frequency. The result is in bit
+        // reversed order, which is fine because it is only multiplied point by point and then
+        // given to ntt_inverse( ), which expects that order.
+        void ntt_forward( limb_type *a, size_t n, const limb_type *roots )
+        {
+            if( n < 2 ) return;
+            const size_t half = n / 2;
+            const limb_type *w = roots + half;
+            for( size_t i = 0; i < half; ++i ) {
+                const limb_type u = a[i];
+                const limb_type v = a[i + half];
+                a[i] = ntt_add( u, v );
+                a[i + half] = ntt_multiply( ntt_sub( u, v ), w[i] );
+            }
+
+            auto low  = [=] { ntt_forward( a, half, roots ); };
+            auto high = [=] { ntt_forward( a + half, half, roots ); };
+            if( n >= ntt_parallel_threshold ) {
+                run_in_parallel( low, high );
+            }
+            else {
+                low( );
+                high( );
+            }
+        }
+
+
+        // Undoes ntt_forward( ) (given the inverse roots) except that the result is n times
+        // too large.
+        void ntt_inverse( limb_type *a, size_t n, const limb_type *roots )
+        {
+            if( n < 2 ) return;
+            const size_t half = n / 2;
+
+            auto low  = [=] { ntt_inverse( a, half, roots ); };
+            auto high = [=] { ntt_inverse( a + half, half, roots ); };
+            if( n >= ntt_parallel_threshold ) {
+                run_in_parallel( low, high );
+            }
+            else {
+                low( );
+                high( );
+            }
+
+            const limb_type *w = roots + half;
+            for( size_t i = 0; i < half; ++i ) {
+                const limb_type u = a[i];
+                const limb_type v = ntt_multiply( a[i + half], w[i] );
+                a[i] = ntt_add( u, v );
+                a[i + half] = ntt_sub( u, v );
+            }
+        }
+
+
+        // r[0 .. an + bn) = a[0 .. an) * b[0 .. bn) using number theoretic transforms. Requires
+        // an + bn <= ntt_max_limbs. The array r must not overlap either a or b.
+        void multiply_ntt( limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            constexpr limb_type coefficient_mask = ( static_cast<limb_type>( 1 ) << ntt_coefficient_bits ) - 1;
+            const size_t coefficients = ntt_coefficients_per_limb * ( an + bn );
+            const size_t n = bit_ceil( coefficients );
+            const bool squaring = ( a == b && an == bn );
+
+            auto split = []( limb_vector &f, const limb_type *x, size_t xn ) {
+                for( size_t i = 0; i < xn; ++i ) {
+                    for( size_t k = 0; k < ntt_coefficients_per_limb; ++k ) {
+                        f[ntt_coefficients_per_limb * i + k] = ( x[i] >> ( ntt_coefficient_bits * k ) ) & coefficient_mask;
+                    }
+                }
+            };
+
+            const limb_vector roots = ntt_roots( n, false );
+            limb_vector fa( n );
+            limb_vector fb;
+            split( fa, a, an );
+            if( squaring ) {
+                ntt_forward( fa.data( ), n, roots.data( ) );
+            }
+            else {
+                fb.resize( n );
+                split( fb, b, bn );
+                auto transform_a = [&] { ntt_forward( fa.data( ), n, roots.data( ) ); };
+                auto transform_b = [&] { ntt_forward( fb.data( ), n, roots.data( ) ); };
+                run_in_parallel( transform_a, transform_b );
+            }
+
+            // Multiply point by point, dividing by n to undo the scaling of the inverse transform.
+            const limb_type n_inverse = ntt_power( n % ntt_prime, ntt_prime - 2 );
+            const limb_vector &g = squaring ? fa : fb;
+            for( size_t i = 0; i < n; ++i ) {
+                fa[i] = ntt_multiply( ntt_multiply( fa[i], g[i] ), n_inverse );
+            }
+            fb.clear( );
+            ntt_inverse( fa.data( ), n, ntt_roots( n, true ).data( ) );
+
+            // Carry the coefficients into limbs.
+            std::fill( r, r + an + bn, 0 );
+            limb_type carry = 0;
+            for( size_t i = 0; i < coefficients; ++i ) {
+                carry += fa[i];
+                r[i / ntt_coefficients_per_limb] |=
+                    ( carry & coefficient_mask ) << ( ntt_coefficient_bits * ( i % ntt_coefficients_per_limb ) );
+                carry >>= ntt_coefficient_bits;
+            }
+        }
+
+
+        // r[0 .. 2n) = a[0 .. n) * b[0 .. n) using Karatsuba's method. Each operand is split
+        // into a low half and a high half. Three half-sized products are computed instead of
+        // four, using the identity a1*b0 + a0*b1 = (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1.
+        void karatsuba( limb_type *r, const limb_type *a, const limb_type *b, size_t n )
+        {
+            if( n < karatsuba_threshold ) {
+                mul_basecase( r, a, n, b, n );
+                return;
+            }
+
+            const size_t low  = n / 2;
+            const size_t high = n - low;
+
+            // The sums of the halves need an extra limb to hold the carry.
+            limb_vector scratch( 4 * ( high + 1 ) );
+            limb_type *a_sum  = scratch.data( );
+            limb_type *b_sum  = a_sum + high + 1;
+            limb_type *middle = b_sum + high + 1;
+            const size_t middle_size = 2 * ( high + 1 );
+
+            a_sum[high] = add( a_sum, a + low, high, a, low );
+            b_sum[high] = add( b_sum, b + low, high, b, low );
+
+            // The low product goes into r[0 .. 2*low) and the high product into r[2*low .. 2n).
+            // The three products are independent so large ones are computed in parallel.
+            auto low_product    = [=] { karatsuba( r, a, b, low ); };
+            auto high_product   = [=] { karatsuba( r + 2 * low, a + low, b + low, high ); };
+            auto middle_product = [=] { karatsuba( middle, a_sum, b_sum, high + 1 ); };
+            if( n >= parallel_threshold ) {
+                run_in_parallel( low_product, high_product, middle_product );
+            }
+            else {
+                low_product( );
+                high_product( );
+                middle_product( );
+            }
+
+            sub( middle, middle, middle_size, r, 2 * low );
+            sub( middle, middle, middle_size, r + 2 * low, 2 * high );
+
+            // Since n >= karatsuba_threshold, the middle product always fits in the space above
+            // r[low]. The final carry is zero because the full product fits in 2n limbs.
+            add( r + low, r + low, 2 * n - low, middle, middle_size );
+        }
+
+
+        // r[0 .. an + bn) = a[0 .. an) * b[0 .. bn). Requires an >= 1 and bn >= 1. The array r
+        // must not overlap either a or b.
+        void multiply( limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            if( an < bn ) {
+                std::swap( a, b );
+                std::swap( an, bn );
+            }
+
+            if( bn < karatsuba_threshold ) {
+                mul_basecase( r, a, an, b, bn );
+                return;
+            }
+            if( bn >= ntt_threshold && an + bn <= ntt_max_limbs ) {
+                multiply_ntt( r, a, an, b, bn );
+                return;
+            }
+            if( an == bn ) {
+                karatsuba( r, a, b, an );
+                return;
+            }
+
+            // The operands are unbalanced. Cut the larger one into pieces the size of the smaller
+            // one and accumulate the partial products.
+            std::fill( r, r + an + bn, 0 );
+            limb_vector partial( 2 * bn );
+            size_t offset = 0;
+            for( ; an - offset >= bn; offset += bn ) {
+                karatsuba( partial.data( ), a + offset, b, bn );
+                add( r + offset, r + offset, an + bn - offset, partial.data( ), 2 * bn );
+            }
+            if( offset < an ) {
+                const size_t rest = an - offset;
+                multiply( partial.data( ), b, bn, a + offset, rest );
+                add( r + offset, r + offset, an + bn - offset, partial.data( ), bn + rest );
+            }
+        }
+
+
+        // Returns the product of two normalized limb vectors as a normalized limb vector.
+        limb_vector multiply( const limb_vector &a, const limb_vector &b )
+        {
+            limb_vector product;
+            if( a.empty( ) || b.empty( ) ) return product;
+
+            product.resize( a.size( ) + b.size( ) );
+            multiply( product.data( ), a.data( ), a.size( ), b.data( ), b.size( ) );
+            normalize( product );
+            return product;
+        }
+
+
+        // acc += a[0 .. an) * b[0 .. bn). Requires an >= 1 and bn >= 1, and acc must not share
+        // storage with a or b. When one operand is short the rows of the product are added
+        // directly into acc, so no temporary storage is needed.
+        void add_product( limb_vector &acc, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            if( an < bn ) {
+                std::swap( a, b );
+                std::swap( an, bn );
+            }
+
+            const size_t size = std::max( acc.size( ), an + bn ) + 1;
+            acc.resize( size );
+            if( bn < karatsuba_threshold ) {
+                for( size_t j = 0; j < bn; ++j ) {
+                    const limb_type carry = addmul_1( acc.data( ) + j, a, an, b[j] );
+                    add_1( acc.data( ) + j + an, acc.data( ) + j + an, size - j - an, carry );
+                }
+            }
+            else {
+                limb_vector product( an + bn );
+                multiply( product.data( ), a, an, b, bn );
+                add( acc.data( ), acc.data( ), size, product.data( ), an + bn );
+            }
+            normalize( acc );
+        }
+
+
+        // Division
+        // ========
+
+        // q[0 .. n) = a[0 .. n) / d. Returns the remainder. The arrays q and a may be the same.
+        limb_type divmod_1( limb_type *q, const limb_type *a, size_t n, limb_type d )
+        {
+            limb_type remainder = 0;
+            for( size_t i = n; i-- > 0; ) {
+                q[i] = divide_wide( remainder, a[i], d, remainder );
+            }
+            return remainder;
         }
+
+
+        // Computes q[0 .. an - bn] = a / b and r[0 .. bn) = a % b using Algorithm D from Knuth,
+        // "The Art of Computer Programming," volume 2, section 4.3.1. Requires an >= bn >= 2 and
+        // that b has no leading zeros.
+        void divmod_knuth(
+            limb_type *q, limb_type *r, const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            // Normalize so the divisor's top bit is set. This ensures that each estimated
+            // quotient digit is too large by at most two.
+            const int shift = countl_zero( b[bn - 1] );
+            limb_vector v( bn );
+            limb_vector u( an + 1 );
+            shift_left( v.data( ), b, bn, shift );
+            u[an] = shift_left( u.data( ), a, an, shift );
+
+            const limb_type v_top  = v[bn - 1];
+            const limb_type v_next = v[bn - 2];
+
+            for( size_t j = an - bn + 1; j-- > 0; ) {
+                // Estimate the quotient digit from the top two limbs of the current remainder.
+                // If the top limb equals v_top the estimate is B - 1, where B = 2**limb_bits.
+                // The remainder of the estimate might then be B or more; in that case the
+                // estimate can't be improved using v_next.
+                limb_type q_hat;
+                limb_type r_hat;
+                bool r_hat_fits = true;
+                if( u[j + bn] >= v_top ) {
+                    q_hat = numeric_limits<limb_type>::max( );
+                    r_hat = u[j + bn - 1] + v_top;
+                    r_hat_fits = ( r_hat >= v_top );
+                }
+                else {
+                    q_hat = divide_wide( u[j + bn], u[j + bn - 1], v_top, r_hat );
+                }
+                while( r_hat_fits ) {
+                    // Is q_hat * v_next > r_hat*B + u[j + bn - 2]?
+                    limb_type high;
+                    const limb_type low = multiply_wide( q_hat, v_next, high );
+                    if( high < r_hat || ( high == r_hat && low <= u[j + bn - 2] ) ) break;
+                    --q_hat;
+                    r_hat += v_top;
+                    r_hat_fits = ( r_hat >= v_top );
+                }
+
+                // Subtract q_hat * v from the current remainder. If the estimate was still one
+                // too large (which is rare) the result is negative and v must be added back.
+                const limb_type borrow = submul_1( u.data( ) + j, v.data( ), bn, q_hat );
+                const limb_type top = u[j + bn];
+                u[j + bn] = top - borrow;
+                if( top < borrow ) {
+                    --q_hat;
+                    u[j + bn] += add_n( u.data( ) + j, u.data( ) + j, v.data( ), bn );
+                }
+                q[j] = q_hat;
+            }
+
+            // Undo the normalization to recover the remainder.
+            shift_right( r, u.data( ), bn, shift );
+        }
+
+
+        // Computes quotient = a / b and remainder = a % b using quadratic methods. Both a and b
+        // must be free of leading zeros and b must not be zero. The results are normalized.
+        void divmod_schoolbook(
+            limb_vector &quotient, limb_vector &remainder,
+            const limb_type *a, size_t an, const limb_type *b, size_t bn )
+        {
+            if( compare( a, an, b, bn ) < 0 ) {
+                quotient.clear( );
+                remainder.assign( a, a + an );
+                return;
+            }
+
+            if( bn == 1 ) {
+                quotient.resize( an );
+                const limb_type rest = divmod_1( quotient.data( ), a, an, b[0] );
+                remainder.clear( );
+                if( rest != 0 ) remainder.push_back( rest );
+            }
+            else {
+                quotient.resize( an - bn + 1 );
+                remainder.resize( bn );
+                divmod_knuth( quotient.data( ), remainder.data( ), a, an, b, bn );
+            }
+            normalize( quotient );
+            normalize( remainder );
+        }
+
+
+        // Returns floor( B**(2n) / b ) where B = 2**limb_bits and b = b[0 .. n) has no leading
+        // zeros. The result has at most n + 1 limbs. If `exact` is false, the result might be
+        // slightly too small, which is all that the recursive calls require.
+        //
+        // For large n, Newton's iteration x' = x + x*(B**(2n) - b*x)/B**(2n) is used. It
+        // doubles the number of correct limbs in each step, so an estimate with half the
+        // precision is computed recursively from the top half of b. The recursion starts from
+        // a slightly too large divisor so the estimate is never too large. Newton's iteration
+        // preserves that property, and the few missing units are added at the end.
+        limb_vector reciprocal( const limb_type *b, size_t n, bool exact = true )
+        {
+            limb_vector quotient;
+            limb_vector remainder;
+
+            if( n < newton_threshold ) {
+                limb_vector power( 2 * n + 1 );
+                power[2 * n] = 1;
+                divmod_schoolbook( quotient, remainder, power.data( ), power.size( ), b, n );
+                return quotient;
+            }
+
+            const size_t k = n / 2 + 2;
+            limb_vector top( b + n - k, b + n );
+            limb_vector r;
+            if( add_1( top.data( ), top.data( ), k, 1 ) != 0 ) {
+                // The top limbs were all ones so top + 1 == B**k. Its reciprocal is B**k.
+                r.resize( k + 1 );
+                r[k] = 1;
+            }
+            else {
+                r = reciprocal( top.data( ), k, false );
+            }
+
+            // The starting estimate is x = r * B**(n - k). Because its low limbs are zero, the
+            // error B**(2n) - b*x is B**(n - k) * e where e = B**(n + k) - b*r.
+            limb_vector product( n + r.size( ) );
+            multiply( product.data( ), b, n, r.data( ), r.size( ) );
+            normalize( product );
+            limb_vector e( n + k );
+            if( product.size( ) <= n + k ) {
+                sub( e.data( ), e.data( ), n + k, product.data( ), product.size( ) );
+            }
+            normalize( e );
+
+            // The Newton correction x*(B**(2n) - b*x)/B**(2n) simplifies to r*e/B**(2k). Only the
+            // top limbs of e affect the result at the precision the estimate can have, so the
+            // low k - 2 limbs are dropped. That only makes the correction smaller.
+            limb_vector x( n - k + r.size( ) + 1 );
+            std::copy( r.begin( ), r.end( ), x.begin( ) + ( n - k ) );
+            const size_t dropped = k - 2;
+            if( e.size( ) > dropped ) {
+                limb_vector correction( r.size( ) + e.size( ) - dropped );
+                multiply( correction.data( ), r.data( ), r.size( ), e.data( ) + dropped, e.size( ) - dropped );
+                normalize( correction );
+                const size_t shift = 2 * k - dropped;
+                if( correction.size( ) > shift ) {
+                    add( x.data( ), x.data( ), x.size( ), correction.data( ) + shift, correction.size( ) - shift );
+                }
+            }
+            normalize( x );
+            if( !exact ) return x;
+
+            // The estimate is now too small by at most a few units. Compute the exact remainder
+            // B**(2n) - b*x and use it to add the missing units.
+            product.assign( n + x.size( ), 0 );
+            multiply( product.data( ), b, n, x.data( ), x.size( ) );
+            normalize( product );
+            limb_vector error( 2 * n );
+            if( product.size( ) <= 2 * n ) {
+                sub( error.data( ), error.data( ), 2 * n, product.data( ), product.size( ) );
+            }
+            normalize( error );
+
+            while( compare( error.data( ), error.size( ), b, n ) >= 0 ) {
+                sub( error.data( ), error.data( ), error.size( ), b, n );
+                normalize( error );
+                x.push_back( 0 );
+                add_1( x.data( ), x.data( ), x.size( ), 1 );
+                normalize( x );
+            }
+            return x;
+        }
+
+
+        // Divides `current` by b = b[0 .. n) where current < b * B**n. The reciprocal of b must
+        // be provided. Only the top limbs of `current` are needed to estimate the quotient as
+        // floor( floor( current / B**(n - 1) ) * inverse / B**(n + 1) ). This is at most two
+        // less than the true quotient (see Barrett's paper), so few corrections are needed.
+        void divide_block(
+            limb_vector &quotient, limb_vector &remainder, const limb_vector &current,
+            const limb_type *b, size_t n, const limb_vector &inverse )
+        {
+            quotient.clear( );
+            if( current.size( ) > n - 1 ) {
+                const size_t top_size = current.size( ) - ( n - 1 );
+                limb_vector product( top_size + inverse.size( ) );
+                multiply( product.data( ), current.data( ) + n - 1, top_size, inverse.data( ), inverse.size( ) );
+                normalize( product );
+                if( product.size( ) > n + 1 ) {
+                    quotient.assign( product.begin( ) + n + 1, product.end( ) );
+                }
+            }
+
+            remainder = current;
+            if( !quotient.empty( ) ) {
+                limb_vector scaled( quotient.size( ) + n );
+                multiply( scaled.data( ), quotient.data( ), quotient.size( ), b, n );
+                normalize( scaled );
+                sub( remainder.data( ), remainder.data( ), remainder.size( ), scaled.data( ), scaled.size( ) );
+                normalize( remainder );
+            }
+
+            while( compare( remainder.data( ), remainder.size( ), b, n ) >= 0 ) {
+                sub( remainder.data( ), remainder.data( ), remainder.size( ), b, n );
+                normalize( remainder );
+                quotient.push_back( 0 );
+                add_1( quotient.data( ), quotient.data( ), quotient.size( ), 1 );
+                normalize( quotient );
+            }
+        }
+
+
+        // Computes quotient = a / b and remainder = a % b given inverse = reciprocal( b, bn ).
+        // The dividend is processed in blocks of bn limbs, from the most significant end, in
+        // the same way that schoolbook division processes one digit at a time.
+        void divmod_newton(
+            limb_vector &quotient, limb_vector &remainder,
+            const limb_type *a, size_t an, const limb_type *b, size_t bn, const limb_vector &inverse )
+        {
+            const size_t blocks = ( an + bn - 1 ) / bn;
+            quotient.assign( blocks * bn, 0 );
+            remainder.clear( );
+
+            limb_vector current;
+            limb_vector block_quotient;
+            for( size_t i = blocks; i-- > 0; ) {
+                // current = remainder * B**bn + (block i of a).
+                const size_t start = i * bn;
+                const size_t end   = std::min( an, start + bn );
+                current.assign( bn + remainder.size( ), 0 );
+                std::copy( a + start, a + end, current.begin( ) );
+                std::copy( remainder.begin( ), remainder.end( ), current.begin( ) + bn );
+                normalize( current );
+
+                divide_block( block_quotient, remainder, current, b, bn, inverse );
+                std::copy( block_quotient.begin( ), block_quotient.end( ), quotient.begin( ) + start );
+            }
+            normalize( quotient );
+        }
+
+
+        // Computes quotient = a / b and remainder = a % b. Both a and b must be free of leading
+        // zeros and b must not be zero. The results are normalized. If the reciprocal of b is
+        // already known it can be provided to avoid computing it again.
+        void divmod(
+            limb_vector &quotient, limb_vector &remainder,
+            const limb_type *a, size_t an, const limb_type *b, size_t bn,
+            const limb_vector *inverse = nullptr )
+        {
+            if( bn < newton_threshold || an < bn + newton_threshold ) {
+                divmod_schoolbook( quotient, remainder, a, an, b, bn );
+            }
+            else if( inverse != nullptr ) {
+                divmod_newton( quotient, remainder, a, an, b, bn, *inverse );
+            }
+            else {
+                divmod_newton( quotient, remainder, a, an, b, bn, reciprocal( b, bn ) );
+            }
+        }
+
+
+        // Decimal Conversion
+        // ==================
+        //
+        // Both directions use the same idea. A number with 2k chunks of decimal digits is
+        // split into a high part and a low part, each with k chunks, using the power of ten
+        // chunk_base**k. The parts are converted recursively. Going from decimal to binary
+        // this requires a multiplication at each step. Going from binary to decimal it requires
+        // a division. Because the split happens in the middle, the total cost is dominated by
+        // the operations at the top level and the conversion runs in O(M(n) log n) time.
+        //
+        // The table `powers` holds chunk_base**(2**k) at index k. It is computed once per
+        // conversion by repeated squaring. When converting to decimal, the reciprocals of the
+        // larger powers are also computed once and then reused for every division by them.
+
+        vector<limb_vector> chunk_powers( size_t levels )
+        {
+            vector<limb_vector> powers;
+            if( levels == 0 ) return powers;
+
+            powers.reserve( levels );
+            powers.push_back( limb_vector{ chunk_base } );
+            while( powers.size( ) < levels ) {
+                powers.push_back( multiply( powers.back( ), powers.back( ) ) );
+            }
+            return powers;
+        }
+
+
+        // Converts chunks[0 .. count) into binary. The least significant chunk is first.
+        limb_vector chunks_to_binary(
+            const limb_type *chunks, size_t count, const vector<limb_vector> &powers )
+        {
+            if( count <= conversion_threshold ) {
+                // Horner's rule. Each step costs time proportional to the size of the result.
+                limb_vector result;
+                result.reserve( count );
+                for( size_t i = count; i-- > 0; ) {
+                    limb_type carry = mul_1( result.data( ), result.data( ), result.size( ), chunk_base );
+                    if( carry != 0 ) result.push_back( carry );
+                    carry = add_1( result.data( ), result.data( ), result.size( ), chunks[i] );
+                    if( carry != 0 ) result.push_back( carry );
+                }
+                return result;
+            }
+
+            // The low part holds the largest power of two number of chunks less than count.
+            const size_t level = bit_width( count - 1 ) - 1;
+            const size_t low_count = static_cast<size_t>( 1 ) << level;
+            limb_vector low  = chunks_to_binary( chunks, low_count, powers );
+            limb_vector high = chunks_to_binary( chunks + low_count, count - low_count, powers );
+            if( high.empty( ) ) return low;
+
+            // result = high * chunk_base**low_count + low. The low part is smaller than the
+            // power of ten so adding it never extends the product.
+            const limb_vector &scale = powers[level];
+            limb_vector result( high.size( ) + scale.size( ) );
+            multiply( result.data( ), high.data( ), high.size( ), scale.data( ), scale.size( ) );
+            if( !low.empty( ) ) {
+                add( result.data( ), result.data( ), result.size( ), low.data( ), low.size( ) );
+            }
+            normalize( result );
+            return result;
+        }
+
+
+        // Converts a[0 .. n) into exactly `count` chunks, least significant first. The count
+        // must be a power of two and the value must be less than chunk_base**count.
+        void binary_to_chunks(
+            const limb_type *a, size_t n, limb_type *chunks, size_t count,
+            const vector<limb_vector> &powers, const vector<limb_vector> &reciprocals )
+        {
+            if( count <= conversion_threshold ) {
+                // Repeatedly divide by chunk_base. Each step costs time proportional to the
+                // size of the remaining value.
+                limb_vector value( a, a + n );
+                size_t size = n;
+                size_t i = 0;
+                while( size > 0 ) {
+                    chunks[i++] = divmod_1( value.data( ), value.data( ), size, chunk_base );
+                    size = significant_size( value.data( ), size );
+                }
+                std::fill( chunks + i, chunks + count, 0 );
+                return;
+            }
+
+            const size_t half  = count / 2;
+            const size_t level = bit_width( half ) - 1;
+            limb_vector quotient;
+            limb_vector remainder;
+            const limb_vector &divisor = powers[level];
+            const limb_vector *inverse = reciprocals[level].empty( ) ? nullptr : &reciprocals[level];
+            divmod( quotient, remainder, a, n, divisor.data( ), divisor.size( ), inverse );
+            binary_to_chunks( remainder.data( ), remainder.size( ), chunks, half, powers, reciprocals );
+            binary_to_chunks( quotient.data( ), quotient.size( ), chunks + half, half, powers, reciprocals );
+        }
+
+
+        // Returns the decimal representation of a[0 .. n), which must be free of leading zeros.
+        string binary_to_decimal( const limb_type *a, size_t n )
+        {
+            if( n == 0 ) return "0";
+
+            // Each chunk holds more than chunk_bits bits, so this many chunks is always enough.
+            // Rounding up to a power of two allows the recursion to split the chunks evenly.
+            const size_t needed = ( n * limb_bits ) / chunk_bits + 1;
+            const size_t count  = bit_ceil( needed );
+            const size_t levels = ( count > conversion_threshold ) ? bit_width( count ) - 1 : 0;
+            const vector<limb_vector> powers = chunk_powers( levels );
+            vector<limb_vector> reciprocals( levels );
+            for( size_t k = 0; k < levels; ++k ) {
+                if( powers[k].size( ) >= newton_threshold ) {
+                    reciprocals[k] = reciprocal( powers[k].data( ), powers[k].size( ) );
+                }
+            }
+
+            limb_vector chunks( count );
+            binary_to_chunks( a, n, chunks.data( ), count, powers, reciprocals );
+
+            size_t top = count - 1;
+            while( chunks[top] == 0 ) --top;
+
+            // The most significant chunk is written without leading zeros. All other chunks are
+            // written using exactly chunk_digits digits.
+            string result = std::to_string( chunks[top] );
+            size_t position = result.size( );
+            result.resize( position + top * chunk_digits );
+            for( size_t i = top; i-- > 0; ) {
+                limb_type chunk = chunks[i];
+                for( size_t k = chunk_digits; k-- > 0; ) {
+                    result[position + k] = static_cast<char>( '0' + chunk % 10 );
+                    chunk /= 10;
+                }
+                position += chunk_digits;
+            }
+            return result;
+        }
+
+
+        // Returns the binary representation of a string of decimal digits. The string must be
+        // free of leading zeros and contain only digits.
+        limb_vector decimal_to_binary( const string &decimal )
+        {
+            const size_t length = decimal.size( );
+            const size_t count  = ( length + chunk_digits - 1 ) / chunk_digits;
+
+            // Chunk i holds the decimal digits that are worth chunk_base**i.
+            limb_vector chunks( count );
+            for( size_t i = 0; i < count; ++i ) {
+                const size_t end   = length - i * chunk_digits;
+                const size_t start = ( end > chunk_digits ) ? end - chunk_digits : 0;
+                limb_type chunk = 0;
+                for( size_t k = start; k < end; ++k ) {
+                    chunk = 10 * chunk + static_cast<limb_type>( decimal[k] - '0' );
+                }
+                chunks[i] = chunk;
+            }
+
+            const size_t levels = ( count > conversion_threshold ) ? bit_width( count - 1 ) : 0;
+            const vector<limb_vector> powers = chunk_powers( levels );
+            return chunks_to_binary( chunks.data( ), count, powers );
+        }
+
+
+        // Modular Exponentiation
+        // ======================
+        //
+        // A "reducer" performs multiplication modulo a fixed modulus on values kept in some
+        // internal representation (a "domain"). The exponentiation algorithm below works with
+        // any reducer that provides to_domain( ), from_domain( ), one( ), and multiply( ).
+
+        // Montgomery reduction represents x as x*R mod m where R = B**n. The product of two
+        // such values can be reduced using only multiplications and shifts, avoiding division
+        // entirely. This requires an odd modulus.
+        class MontgomeryReducer {
+        public:
+            explicit MontgomeryReducer( const limb_vector &modulus ) :
+                m( modulus ), n( modulus.size( ) )
+            {
+                // Compute -m**(-1) mod B using Newton's iteration. The initial value is correct
+                // to three bits (for any odd m, m*m == 1 mod 8) and each step doubles that.
+                limb_type inverse = m[0];
+                for( int bits = 3; bits < limb_bits; bits *= 2 ) {
+                    inverse *= 2 - m[0] * inverse;
+                }
+                m_negative_inverse = 0 - inverse;
+            }
+
+            // Values in the domain are always exactly n limbs.
+            limb_vector to_domain( const limb_vector &x ) const
+            {
+                limb_vector shifted( n + x.size( ) );
+                std::copy( x.begin( ), x.end( ), shifted.begin( ) + n );
+                normalize( shifted );
+                limb_vector quotient;
+                limb_vector remainder;
+                divmod( quotient, remainder, shifted.data( ), shifted.size( ), m.data( ), n );
+                remainder.resize( n );
+                return remainder;
+            }
+
+            limb_vector from_domain( const limb_vector &x ) const
+            {
+                limb_vector t( 2 * n + 1 );
+                std::copy( x.begin( ), x.end( ), t.begin( ) );
+                limb_vector result = reduce( t );
+                normalize( result );
+                return result;
+            }
+
+            limb_vector one( ) const
+            {
+                return to_domain( limb_vector{ 1 } );
+            }
+
+            limb_vector multiply( const limb_vector &x, const limb_vector &y ) const
+            {
+                limb_vector t( 2 * n + 1 );
+                vtsu::multiply( t.data( ), x.data( ), n, y.data( ), n );
+                return reduce( t );
+            }
+
+        private:
+            limb_vector m;
+            size_t      n;
+            limb_type   m_negative_inverse;
+
+            // Returns t / R mod m where t = t[0 .. 2n + 1) < m*R. Each step adds a multiple of m
+            // that clears the lowest remaining limb of t.
+            limb_vector reduce( limb_vector &t ) const
+            {
+                for( size_t i = 0; i < n; ++i ) {
+                    const limb_type u = t[i] * m_negative_inverse;
+                    limb_type carry = addmul_1( t.data( ) + i, m.data( ), n, u );
+                    for( size_t k = i + n; carry != 0; ++k ) {
+                        t[k] += carry;
+                        carry = ( t[k] < carry ) ? 1 : 0;
+                    }
+                }
+                limb_vector result( t.begin( ) + n, t.begin( ) + 2 * n );
+                if( t[2 * n] != 0 || compare_n( result.data( ), m.data( ), n ) >= 0 ) {
+                    sub_n( result.data( ), result.data( ), m.data( ), n );
+                }
+                return result;
+            }
+        };
+
+
+        // Barrett reduction uses the precomputed reciprocal of the modulus to replace each
+        // division with two multiplications. It works for any modulus, and since it is built on
+        // the general multiplication it scales well to very large moduli.
+        class BarrettReducer {
+        public:
+            explicit BarrettReducer( const limb_vector &modulus ) :
+                m( modulus ), inverse( reciprocal( modulus.data( ), modulus.size( ) ) )
+            { }
+
+            limb_vector to_domain( const limb_vector &x ) const
+                { return x; }
+
+            limb_vector from_domain( const limb_vector &x ) const
+                { return x; }
+
+            limb_vector one( ) const
+                { return limb_vector{ 1 }; }
+
+            limb_vector multiply( const limb_vector &x, const limb_vector &y ) const
+            {
+                limb_vector quotient;
+                limb_vector remainder;
+                divide_block( quotient, remainder, vtsu::multiply( x, y ), m.data( ), m.size( ), inverse );
+                return remainder;
+            }
+
+        private:
+            limb_vector m;
+            limb_vector inverse;
+        };
+
+
+        // Computes base**exponent in the reducer's domain using sliding windows. The odd powers
+        // base**1, base**3, ..., base**(2**w - 1) are precomputed. The exponent is then scanned
+        // from its most significant bit, squaring for each bit and multiplying by a table entry
+        // once for each window of up to w bits. The base must already be reduced and the
+        // exponent must not be zero.
+        template<typename Reducer>
+        limb_vector power_mod( const Reducer &reducer, const limb_vector &base, const limb_vector &exponent )
+        {
+            const size_t bits = exponent.size( ) * limb_bits - countl_zero( exponent.back( ) );
+            auto bit = [&exponent]( size_t i ) -> unsigned {
+                return ( exponent[i / limb_bits] >> ( i % limb_bits ) ) & 1U;
+            };
+
+            // Larger windows need fewer multiplications but a larger table.
+            size_t window = 1;
+            if( bits >  7 ) window = 2;
+            if( bits > 23 ) window = 3;
+            if( bits > 79 ) window = 4;
+            if( bits > 239 ) window = 5;
+            if( bits > 671 ) window = 6;
+
+            vector<limb_vector> table( static_cast<size_t>( 1 ) << ( window - 1 ) );
+            table[0] = reducer.to_domain( base );
+            if( table.size( ) > 1 ) {
+                const limb_vector square = reducer.multiply( table[0], table[0] );
+                for( size_t i = 1; i < table.size( ); ++i ) {
+                    table[i] = reducer.multiply( table[i - 1], square );
+                }
+            }
+
+            limb_vector result;
+            bool started = false;
+            size_t i = bits;
+            while( i > 0 ) {
+                if( bit( i - 1 ) == 0 ) {
+                    result = reducer.multiply( result, result );
+                    --i;
+                    continue;
+                }
+
+                // Find the longest window of at most `window` bits that ends with a one bit.
+                size_t j = ( i > window ) ? i - window : 0;
+                while( bit( j ) == 0 ) ++j;
+                size_t value = 0;
+                for( size_t k = i; k-- > j; ) {
+                    value = ( value << 1 ) | bit( k );
+                    if( started ) result = reducer.multiply( result, result );
+                }
+                if( started ) {
+                    result = reducer.multiply( result, table[value >> 1] );
+                }
+                else {
+                    result = table[value >> 1];
+                    started = true;
+                }
+                i = j;
+            }
+            return reducer.from_domain( result );
+        }
+
+
+        // Bitwise Operations
+        // ==================
+
+        // Returns the two's complement form of the value with the given magnitude and sign,
+        // using exactly `n` limbs. Requires n > magnitude.size( ).
+        limb_vector to_twos_complement( const limb_vector &magnitude, bool negative, size_t n )
+        {
+            limb_vector result( n );
+            std::copy( magnitude.begin( ), magnitude.end( ), result.begin( ) );
+            if( negative ) {
+                // -x == ~( x - 1 ).
+                sub_1( result.data( ), result.data( ), n, 1 );
+                for( auto &limb : result ) limb = ~limb;
+            }
+            return result;
+        }
+
+
+        // Converts a two's complement value in place to a magnitude without leading zeros.
+        // Returns true if the value is negative.
+        bool from_twos_complement( limb_vector &value )
+        {
+            const bool negative = ( value.back( ) >> ( limb_bits - 1 ) ) != 0;
+            if( negative ) {
+                for( auto &limb : value ) limb = ~limb;
+                add_1( value.data( ), value.data( ), value.size( ), 1 );
+            }
+            normalize( value );
+            return negative;
+        }
+
     }
 
 
     BigInteger::BigInteger( const string &raw_digits )
     {
-        // Check to ensure all characters of the string are digits.
-        for_each( raw_digits.begin( ), raw_digits.end( ), [ ]( char c ) {
+        // Skip over a leading sign, if there is one.
+        const bool has_sign = !raw_digits.empty( ) && ( raw_digits[0] == '-' || raw_digits[0] == '+' );
+        const string::size_type first_digit_position = has_sign ? 1 : 0;
+        if( has_sign && raw_digits.size( ) == 1 ) {
+            throw InvalidFormat( "Sign without digits in BigInteger::BigInteger( const string & )" );
+        }
+
+        // Check to ensure all other characters of the string are digits.
+        for_each( raw_digits.begin( ) + first_digit_position, raw_digits.end( ), [ ]( char c ) {
             if( !isdigit( c ) ) throw InvalidFormat( "Non-digit in BigInteger::BigInteger( const string & )" );
         } );
 
         // Find the first non-zero digit.
-        string::size_type first_non_zero_digit_position = raw_digits.find_first_not_of( '0' );
+        string::size_type first_non_zero_digit_position =
+            raw_digits.find_first_not_of( '0', first_digit_position );
 
-        // If the string is all zero digits, we're done.
+        // If the string is all zero digits, we're done. Zero is never negative.
         if( first_non_zero_digit_position == string::npos ) return;
 
-        bool in_number = false;
-        for( char digit_character : raw_digits ) {
-            if( !in_number && digit_character == '0' ) continue;
+        // The fundamental complexity with this method is that we are converting from a base 10
+        // digit string to a base 2**64 digit stream. See decimal_to_binary( ) for the details.
+        static_assert( is_same_v<storage_type, limb_type> );
+        digits = decimal_to_binary( raw_digits.substr( first_non_zero_digit_position ) );
+        negative = ( raw_digits[0] == '-' );
+    }
+
+
+    void BigInteger::add_signed( const BigInteger &right, bool right_negative )
+    {
+        // First deal with the case when the right number is zero. This is needed because zero
+        // is represented in a special way.
+        if( right.digits.size( ) == 0 ) return;
 
-            in_number = true;
+        // If the signs are the same (or this is zero) the magnitudes are added.
+        if( digits.size( ) == 0 || negative == right_negative ) {
+            negative = right_negative;
 
-            // TODO: Find a better way to do this.
-            // This works, but it relies on complex mathematical operations and implicit type
-            // conversions from `unsigned long` to BigInteger. The fundamental complexity with
-            // this method is that we are converting from a base 10 digit string to a base 2**32
-            // digit stream.
-            *this *= 10UL;
-            *this += static_cast<unsigned long>( digit_character - '0' );
+            // Make room for the largest possible sum before starting. This way the addition can
+            // be done in place and the digits are never reallocated in the middle of the loop.
+            // Digits beyond the end of the shorter number are zero.
+            const size_t max_size = std::max( digits.size( ), right.digits.size( ) );
+            digits.reserve( max_size + 1 );
+            digits.resize( max_size );
+
+            // This works even when `right` is `*this`; see add( ).
+            const storage_type carry =
+                add( digits.data( ), digits.data( ), max_size, right.digits.data( ), right.digits.size( ) );
+
+            // Handle an overall carry if there is one.
+            if( carry != 0 ) {
+                digits.push_back( carry );
+            }
+            return;
         }
+
+        // Otherwise the smaller magnitude is subtracted from the larger one, and the result has
+        // the sign of the value with the larger magnitude. If `right` is `*this` the magnitudes
+        // are equal and the result is zero.
+        const int order =
+            compare( digits.data( ), digits.size( ), right.digits.data( ), right.digits.size( ) );
+        if( order == 0 ) {
+            digits.clear( );
+            negative = false;
+            return;
+        }
+        if( order > 0 ) {
+            sub( digits.data( ), digits.data( ), digits.size( ), right.digits.data( ), right.digits.size( ) );
+        }
+        else {
+            // The difference is written over the (shorter) digits of this object as they are
+            // used; see sub( ).
+            const size_t size = digits.size( );
+            digits.resize( right.digits.size( ) );
+            sub( digits.data( ), right.digits.data( ), right.digits.size( ), digits.data( ), size );
+            negative = right_negative;
+        }
+        normalize( digits );
     }
 
 
     BigInteger &BigInteger::operator+=( const BigInteger &right )
     {
-        // First deal with the case when one (or both) of the numbers are zero. This is needed
-        // because zero is represented in a special way.
-        if( right.digits.size( ) == 0 ) return *this;
-        if( digits.size( ) == 0 ) {
-            digits = right.digits;
+        add_signed( right, right.negative );
+        return *this;
+    }
+
+
+    BigInteger &BigInteger::operator-=( const BigInteger &right )
+    {
+        add_signed( right, !right.negative );
+        return *this;
+    }
+
+
+    BigInteger &BigInteger::operator*=( const BigInteger &right )
+    {
+        // Multiplying by zero produces zero, which has no digits.
+        if( digits.size( ) == 0 || right.digits.size( ) == 0 ) {
+            digits.clear( );
+            negative = false;
             return *this;
         }
 
-        // Both numbers are non-zero...
+        static_assert( is_same_v<decltype( digits ), limb_vector> );
 
-        // How many digits do we have to process?
-        const unsigned max_size =
-            ( digits.size( ) > right.digits.size( ) ) ? digits.size( ) : right.digits.size( );
+        // The product is computed into separate storage since the multiplication algorithms
+        // can't overwrite their operands as they go. This also makes `x *= x` work. Small
+        // products are computed on the stack so that multiplying small values never allocates.
+        const size_t product_size = digits.size( ) + right.digits.size( );
+        if( product_size <= 2 * inline_digits ) {
+            storage_type product[2 * inline_digits] = { };
+            multiply( product, digits.data( ), digits.size( ), right.digits.data( ), right.digits.size( ) );
+            digits.assign( product, product + significant_size( product, product_size ) );
+        }
+        else {
+            limb_vector product( product_size );
+            multiply( product.data( ), digits.data( ), digits.size( ), right.digits.data( ), right.digits.size( ) );
+            normalize( product );
+            digits = std::move( product );
+        }
+        negative = ( negative != right.negative );
+        return *this;
+    }
 
-        storage_type other_digit;
-        compute_type sum;
-        compute_type carry = 0;
 
-        // Process all digits...
-        for( vector<storage_type>::size_type digit_index = 0; digit_index < max_size; ++digit_index ) {
-            
-            // If I'm out of digits, I need to expand.
-            if( digit_index > digits.size( ) - 1 ) digits.push_back( 0 );
+    BigInteger &BigInteger::add_mul_small( const BigInteger &value, std::uint64_t factor )
+    {
+        if( value.digits.size( ) == 0 || factor == 0 ) return *this;
+
+        // The digits of `value` are overwritten as we go if it is this object, so work on a copy.
+        if( &value == this ) {
+            const BigInteger copy( value );
+            return add_mul_small( copy, factor );
+        }
+
+        // The single pass below only adds magnitudes. When the signs differ, do it the long way.
+        if( digits.size( ) != 0 && negative != value.negative ) {
+            return *this += value * BigInteger( factor );
+        }
+        negative = value.negative;
+
+        // As with operator+=, make room for the largest possible result before starting.
+        const size_t value_size = value.digits.size( );
+        const size_t max_size = std::max( digits.size( ), value_size + 1 );
+        digits.reserve( max_size + 1 );
+        digits.resize( max_size );
+
+        const storage_type carry =
+            addmul_1( digits.data( ), value.digits.data( ), value_size, factor );
+        const storage_type overall =
+            add_1( digits.data( ) + value_size, digits.data( ) + value_size, max_size - value_size, carry );
+        if( overall != 0 ) digits.push_back( overall );
+        normalize( digits );
+        return *this;
+    }
 
-            // If the other number is out of digits, use zero; otherwise use its digit.
-            if( digit_index > right.digits.size( ) - 1 ) {
-                other_digit = 0;
-            }
-            else {
-                other_digit = right.digits[digit_index];
-            }
 
-            const compute_type digit_modulus =
-                static_cast<compute_type>( numeric_limits<storage_type>::max( ) ) + 1;
+    BigInteger &BigInteger::operator/=( const BigInteger &right )
+    {
+        *this = divmod( *this, right ).first;
+        return *this;
+    }
+
+
+    BigInteger &BigInteger::operator%=( const BigInteger &right )
+    {
+        *this = divmod( *this, right ).second;
+        return *this;
+    }
 
-            // Do the addition. Note that if we try to add two digits directly, without first
-            // casting one of them, the computation will be done in storage_type, which might
-            // overflow.
-            sum = static_cast<compute_type>( digits[digit_index] ) + other_digit + carry;
-            digits[digit_index] = static_cast<storage_type>( sum % digit_modulus );
-            carry = sum / digit_modulus;
+
+    template<typename Operation>
+    void BigInteger::bitwise( const BigInteger &right, Operation operation )
+    {
+        // One extra limb holds the sign bits. Since the magnitudes have no leading zeros the
+        // top bit of that limb is the sign of the two's complement value.
+        const size_t size = std::max( digits.size( ), right.digits.size( ) ) + 1;
+        limb_vector result = to_twos_complement( digits, negative, size );
+        const limb_vector other = to_twos_complement( right.digits, right.negative, size );
+        for( size_t i = 0; i < size; ++i ) {
+            result[i] = operation( result[i], other[i] );
         }
+        negative = from_twos_complement( result );
+        digits = std::move( result );
+    }
+
 
-        // Handle an overall carry if there is one.
-        if( carry != 0 ) {
-            digits.push_back( static_cast<storage_type>( carry ) );
+    BigInteger &BigInteger::operator&=( const BigInteger &right )
+    {
+        // The common case of two non-negative values can be done without any conversions.
+        if( !negative && !right.negative ) {
+            const size_t size = std::min( digits.size( ), right.digits.size( ) );
+            for( size_t i = 0; i < size; ++i ) {
+                digits[i] &= right.digits[i];
+            }
+            digits.resize( size );
+            normalize( digits );
+            return *this;
         }
+        bitwise( right, [ ]( limb_type a, limb_type b ) { return a & b; } );
         return *this;
     }
 
 
-    BigInteger &BigInteger::operator*=( const BigInteger &right )
+    BigInteger &BigInteger::operator|=( const BigInteger &right )
+    {
+        bitwise( right, [ ]( limb_type a, limb_type b ) { return a | b; } );
+        return *this;
+    }
+
+
+    BigInteger &BigInteger::operator^=( const BigInteger &right )
     {
-        // TODO: Finish Me!
+        bitwise( right, [ ]( limb_type a, limb_type b ) { return a ^ b; } );
         return *this;
     }
 
 
-    BigInteger::operator unsigned long( )
+    BigInteger &BigInteger::operator<<=( std::size_t count )
+    {
+        if( digits.size( ) == 0 ) return *this;
+
+        const size_t limb_shift = count / limb_bits;
+        const int    bit_shift  = static_cast<int>( count % limb_bits );
+        const size_t size       = digits.size( );
+
+        // Shift the bits in place first and then move whole limbs upward. The limbs must be
+        // moved from the top down since the source and destination overlap.
+        digits.resize( size + limb_shift + 1 );
+        digits[size] = shift_left( digits.data( ), digits.data( ), size, bit_shift );
+        if( limb_shift > 0 ) {
+            std::copy_backward( digits.begin( ), digits.begin( ) + size + 1, digits.end( ) );
+            std::fill( digits.begin( ), digits.begin( ) + limb_shift, 0 );
+        }
+        normalize( digits );
+        return *this;
+    }
+
+
+    BigInteger &BigInteger::operator>>=( std::size_t count )
+    {
+        if( digits.size( ) == 0 ) return *this;
+
+        const size_t limb_shift = count / limb_bits;
+        const int    bit_shift  = static_cast<int>( count % limb_bits );
+
+        // Negative values are rounded toward negative infinity, so if any one bits are shifted
+        // out of a negative value its magnitude must be increased by one.
+        bool round_down = false;
+        if( negative ) {
+            const size_t whole = std::min( limb_shift, digits.size( ) );
+            round_down = any_of( digits.begin( ), digits.begin( ) + whole, [ ]( limb_type d ) { return d != 0; } );
+            if( limb_shift < digits.size( ) && bit_shift != 0 ) {
+                round_down = round_down || ( digits[limb_shift] & ( ( limb_type( 1 ) << bit_shift ) - 1 ) ) != 0;
+            }
+        }
+
+        if( limb_shift >= digits.size( ) ) {
+            digits.clear( );
+        }
+        else {
+            // Moving the limbs downward can be done from the bottom up; see shift_right( ).
+            const size_t size = digits.size( ) - limb_shift;
+            shift_right( digits.data( ), digits.data( ) + limb_shift, size, bit_shift );
+            digits.resize( size );
+            normalize( digits );
+        }
+
+        if( round_down ) {
+            digits.push_back( 0 );
+            add_1( digits.data( ), digits.data( ), digits.size( ), 1 );
+            normalize( digits );
+        }
+        else if( digits.size( ) == 0 ) {
+            negative = false;
+        }
+        return *this;
+    }
+
+
+    BigInteger BigInteger::operator-( ) const
+    {
+        BigInteger result( *this );
+        if( result.digits.size( ) != 0 ) result.negative = !negative;
+        return result;
+    }
+
+
+    BigInteger BigInteger::operator~( ) const
+    {
+        BigInteger result( -*this );
+        result -= BigInteger( 1 );
+        return result;
+    }
+
+
+    BigInteger::operator unsigned long( ) const
     {
         unsigned long value = 0;
 
         // Handle the special case of zero.
         if( digits.size( ) == 0 ) return value;
 
-        vector<storage_type>::size_type digit_index = digits.size( ) - 1;
+        // Since a digit is at least as large as an unsigned long, only a single digit value
+        // can be converted.
+        if( negative || digits.size( ) > 1 || digits[0] > numeric_limits<unsigned long>::max( ) ) {
+            throw std::overflow_error( "BigInteger out of range for unsigned long" );
+        }
+        value = static_cast<unsigned long>( digits[0] );
+        return value;
+    }
 
-        const compute_type digit_modulus =
-            static_cast<compute_type>( numeric_limits<storage_type>::max( ) ) + 1;
 
-        while( digit_index >= 0 ) {
-            value = digit_modulus * value + digits[digit_index];
-            digit_index--;
+    BigInteger::operator long( ) const
+    {
+        if( digits.size( ) == 0 ) return 0;
+
+        // The most negative long has a magnitude one larger than the most positive long.
+        const storage_type limit = static_cast<storage_type>( numeric_limits<long>::max( ) ) + ( negative ? 1 : 0 );
+        if( digits.size( ) > 1 || digits[0] > limit ) {
+            throw std::overflow_error( "BigInteger out of range for long" );
         }
-        // TODO: Add overflow check. We should probably throw an exception.
-        return value;
+
+        // Subtract before negating so that the most negative long doesn't overflow.
+        if( negative ) return -static_cast<long>( digits[0] - 1 ) - 1;
+        return static_cast<long>( digits[0] );
     }
 
 
-    ostream &operator<<( ostream &os, const BigInteger &bi )
+    bool operator==( const BigInteger &left, const BigInteger &right )
     {
-        // The number zero must be handled as a special case.
-        if( bi.digits.size( ) == 0 ) {
-            os << '0';
+        return left.negative == right.negative &&
+            compare( left.digits.data( ), left.digits.size( ), right.digits.data( ), right.digits.size( ) ) == 0;
+    }
+
+
+    strong_ordering operator<=>( const BigInteger &left, const BigInteger &right )
+    {
+        if( left.negative != right.negative ) {
+            return left.negative ? strong_ordering::less : strong_ordering::greater;
         }
-        else {
-            // This is a little dangerous. What if the number of digits was greater than the
-            // type int could represent? That happens for numbers with more than two billion
-            // digits. We need digit_index to be int so the test 'digit_index >= 0' can be
-            // false.
-            int digit_index = static_cast<int>( bi.digits.size( ) ) - 1;
+        // When both values are negative the one with the larger magnitude is smaller.
+        const int magnitude_order =
+            compare( left.digits.data( ), left.digits.size( ), right.digits.data( ), right.digits.size( ) );
+        return ( left.negative ? -magnitude_order : magnitude_order ) <=> 0;
+    }
 
-            // 
-            // TODO: No, no, no, no. Not even close! Fix this!
-            // Maybe print in hex as a temporary work-around? Otherwise we need to implement
-            // division and modulus, which are hard.
-            while( digit_index >= 0) {
-                os << static_cast<char>( bi.digits[digit_index] + '0' );
-                digit_index--;
-            }
+
+    void set_multiplication_threads( unsigned thread_count )
+    {
+        multiplication_pool_pointer( ) = make_multiplication_pool( thread_count );
+    }
+
+
+    BigInteger fma( const BigInteger &a, const BigInteger &b, BigInteger c )
+    {
+        if( a.digits.size( ) == 0 || b.digits.size( ) == 0 ) return c;
+
+        // Only magnitudes can be accumulated directly. When the product has the opposite sign
+        // of `c` it is computed separately.
+        const bool product_negative = ( a.negative != b.negative );
+        if( c.digits.size( ) != 0 && c.negative != product_negative ) {
+            c += a * b;
+            return c;
+        }
+
+        // The product is added into the digits of `c` directly. Since `c` is a separate object
+        // its storage can't overlap that of `a` or `b`.
+        add_product( c.digits, a.digits.data( ), a.digits.size( ), b.digits.data( ), b.digits.size( ) );
+        c.negative = product_negative;
+        return c;
+    }
+
+
+    pair<BigInteger, BigInteger> divmod( const BigInteger &dividend, const BigInteger &divisor )
+    {
+        if( divisor.digits.size( ) == 0 ) {
+            throw BigInteger::DivisionByZero( "Division by zero in divmod( )" );
         }
+
+        pair<BigInteger, BigInteger> result;
+        if( dividend.digits.size( ) == 0 ) return result;
+
+        divmod( result.first.digits, result.second.digits,
+                dividend.digits.data( ), dividend.digits.size( ),
+                divisor.digits.data( ), divisor.digits.size( ) );
+
+        // The magnitudes are the same as for unsigned division. The quotient is negative when
+        // the signs differ and the remainder has the sign of the dividend.
+        result.first.negative  = result.first.digits.size( ) != 0 && ( dividend.negative != divisor.negative );
+        result.second.negative = result.second.digits.size( ) != 0 && dividend.negative;
+        return result;
+    }
+
+
+    BigInteger pow_mod( const BigInteger &base, const BigInteger &exponent, const BigInteger &modulus )
+    {
+        if( modulus.digits.size( ) == 0 ) {
+            throw BigInteger::DivisionByZero( "Zero modulus in pow_mod( )" );
+        }
+        if( modulus.negative ) throw std::domain_error( "Negative modulus in pow_mod( )" );
+        if( exponent.negative ) throw std::domain_error( "Negative exponent in pow_mod( )" );
+
+        // Every value is zero modulo one.
+        BigInteger result;
+        if( modulus.digits.size( ) == 1 && modulus.digits[0] == 1 ) return result;
+
+        if( exponent.digits.size( ) == 0 ) {
+            result.digits.push_back( 1 );
+            return result;
+        }
+
+        // Reduce the base first so that all values in the computation are less than modulus.
+        // A negative base leaves a negative remainder, which is moved into [0, modulus).
+        BigInteger reduced_base = base % modulus;
+        if( reduced_base.digits.size( ) == 0 ) return result;
+        if( reduced_base.negative ) reduced_base += modulus;
+
+        const limb_vector &m = modulus.digits;
+        if( ( m[0] & 1U ) != 0 && m.size( ) < montgomery_threshold ) {
+            result.digits = power_mod( MontgomeryReducer( m ), reduced_base.digits, exponent.digits );
+        }
+        else {
+            result.digits = power_mod( BarrettReducer( m ), reduced_base.digits, exponent.digits );
+        }
+        return result;
+    }
+
+
+    ostream &operator<<( ostream &os, const BigInteger &bi )
+    {
+        // The number zero is handled as a special case by binary_to_decimal( ).
+        if( bi.negative ) os << '-';
+        os << binary_to_decimal( bi.digits.data( ), bi.digits.size( ) );
         return os;
     }
     
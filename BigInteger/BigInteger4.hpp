@@ -2,25 +2,52 @@
  *  \brief  A "fourth generation" definition of an extended precision integer class.
  *  \author Peter Chapin <peter.chapin@vermontstate.edu>
  * 
- * In this version a vector<storage_type> is used to hold the digits. Since vectors have their
- * own lifecycle operations which are invoked by the lifecycle operations generated by the
- * compiler for this class, there is a massive amount of simplification here.
+ * In this version a vector-like container is used to hold the digits. Since that container has
+ * its own lifecycle operations which are invoked by the lifecycle operations generated by the
+ * compiler for this class, there is a massive amount of simplification here. The container is a
+ * SmallVector which holds values up to 128 bits inside the BigInteger object itself, so working
+ * with small values does not allocate memory at all. Larger values spill to the heap.
+ *
+ * Values are signed. The magnitude is stored as digits base 2**64 together with a separate sign
+ * flag, and the bitwise operations behave as if values were in two's complement with infinitely
+ * many sign bits (as in Python or GMP). Conversions to and from decimal strings use a divide-and-conquer
+ * algorithm (see BigInteger4.cpp) so that very large values can be parsed and printed in much
+ * less than quadratic time. Very large products are computed in parallel, using Karatsuba's
+ * method or a number theoretic transform depending on their size.
  */
 
 
 #ifndef BIGINTEGER_HPP
 #define BIGINTEGER_HPP
 
+#include <compare>
+#include <concepts>
+#include <cstdint>
 #include <iosfwd>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <type_traits>
+#include <utility>
+
+#include "SmallVector.hpp"
 
 namespace vtsu {
 
     class BigInteger {
 
         friend std::ostream &operator<<( std::ostream &os, const BigInteger &bi );
+
+        friend std::pair<BigInteger, BigInteger> divmod( const BigInteger &dividend, const BigInteger &divisor );
+
+        friend BigInteger pow_mod( const BigInteger &base, const BigInteger &exponent, const BigInteger &modulus );
+
+        friend BigInteger fma( const BigInteger &a, const BigInteger &b, BigInteger c );
+
+        friend bool operator==( const BigInteger &left, const BigInteger &right );
+
+        friend std::strong_ordering operator<=>( const BigInteger &left, const BigInteger &right );
         
     public:
         //! Exception thrown when an invalid format is used to construct a BigInteger.
@@ -29,6 +56,12 @@ namespace vtsu {
             InvalidFormat( const std::string &message ) : std::runtime_error( message ) { }
         };
 
+        //! Exception thrown when an attempt is made to divide by zero.
+        class DivisionByZero : public std::domain_error {
+        public:
+            DivisionByZero( const std::string &message ) : std::domain_error( message ) { }
+        };
+
         //! Exception thrown when an operation is not implemented.
         class NotImplemented : std::logic_error {
         public:
@@ -46,14 +79,21 @@ namespace vtsu {
         //BigInteger( BigInteger &&other );                 // Move constructor.
         //BigInteger &operator=( BigInteger &&other );      // Move assignment operator.
 
-        BigInteger( unsigned long value );
+        //! Constructs a BigInteger from a value of any built-in integer type.
+        template<std::integral Integer> requires ( !std::same_as<Integer, bool> )
+        BigInteger( Integer value );
 
         /*!
          * \param raw_digits The string of decimal digits. The digits are assumed to be in
          *  big-endian order. That is, the most significant digit is first and the least
-         *  significant digit is last. No characters other than digits are allowed.
+         *  significant digit is last. A single leading '-' or '+' is allowed. No other
+         *  characters than digits are allowed.
+         *
+         * The conversion is done in O(M(n) log n) time, where M(n) is the cost of multiplying
+         * two n digit numbers. Thus even strings with millions of digits are handled quickly.
          * 
-         * \throws InvalidFormat if the string contains any non-digit characters.
+         * \throws InvalidFormat if the string contains any non-digit characters (other than a
+         * leading sign) or if it contains no digits after the sign.
          * \throws std::overflow_error if the string contains a value that is too large to be
          * represented by a BigInteger.
          */
@@ -65,25 +105,107 @@ namespace vtsu {
         // reference to const since the operations do not attempt to modify their right
         // operands. These methods return a reference to 'this' so that they can be chained.
         BigInteger &operator+=( const BigInteger &right );
+        BigInteger &operator-=( const BigInteger &right );
         BigInteger &operator*=( const BigInteger &right );
 
-        //! Conversion operator to convert BigInteger to unsigned long.
+        //! Adds value * factor to this BigInteger, where factor is a single digit.
+        /*!
+         * This is done in one pass over the digits of `value` without creating the product
+         * as a separate object. Thus loops such as `sum.add_mul_small( term, 10 )` do not
+         * allocate memory once `sum` has grown to its final size.
+         */
+        BigInteger &add_mul_small( const BigInteger &value, std::uint64_t factor );
+
+        //! Division and remainder.
+        /*!
+         * Division uses Knuth's Algorithm D for moderate sizes. When both the divisor and the
+         * quotient are large, the reciprocal of the divisor is computed with Newton's method
+         * and division is done with multiplications instead.
+         *
+         * As with the built-in types, the quotient is truncated toward zero and the remainder
+         * has the sign of the dividend.
+         *
+         * \throws DivisionByZero if `right` is zero.
+         */
+        BigInteger &operator/=( const BigInteger &right );
+        BigInteger &operator%=( const BigInteger &right );
+
+        //! Bitwise operations.
+        /*!
+         * These treat both operands as two's complement values with an unlimited number of
+         * sign bits. For example -1 has all bits set, so `x & -1` is `x` for every x.
+         */
+        BigInteger &operator&=( const BigInteger &right );
+        BigInteger &operator|=( const BigInteger &right );
+        BigInteger &operator^=( const BigInteger &right );
+
+        //! Shifts.
+        /*!
+         * Shifting left by n multiplies by 2**n. Shifting right by n divides by 2**n rounding
+         * toward negative infinity, so the result is the same as shifting the two's complement
+         * representation. For example -5 >> 1 is -3.
+         */
+        BigInteger &operator<<=( std::size_t count );
+        BigInteger &operator>>=( std::size_t count );
+
+        BigInteger operator-( ) const;
+        BigInteger operator~( ) const;  // Computes -x - 1, as for two's complement values.
+
+        //! Returns -1, 0, or +1 if this BigInteger is negative, zero, or positive.
+        int sign( ) const
+            { return negative ? -1 : ( digits.empty( ) ? 0 : 1 ); }
+
+        //! Conversion operators to convert BigInteger to built-in types.
         /*!
-         * \throws std::overflow_error if the BigInteger is too large to fit in an unsigned long.
+         * \throws std::overflow_error if the BigInteger is out of range for the target type.
          */
-        operator unsigned long( );
+        explicit operator unsigned long( ) const;
+        explicit operator long( ) const;
 
     private:
-        using storage_type = std::uint16_t;
-        using compute_type = std::uint32_t;
+        using storage_type = std::uint64_t;
+
+        // Number of digits stored without using the heap (enough for a 128 bit value).
+        static constexpr std::size_t inline_digits = 128 / std::numeric_limits<storage_type>::digits;
 
         // INVARIANT: If the represented value is zero, the digits vector is empty. Otherwise
         // the first digit in the vector is the least signification digit. Leading zero digits
-        // are never stored.
-        std::vector<storage_type> digits;
+        // are never stored. The digits hold the magnitude of the value. Zero is never negative.
+        SmallVector<storage_type, inline_digits> digits;
+        bool negative = false;
+
+        // Adds right (with its sign taken to be `right_negative`) to this BigInteger.
+        void add_signed( const BigInteger &right, bool right_negative );
+
+        // Applies a bitwise operation to the two's complement forms of this and right.
+        template<typename Operation>
+        void bitwise( const BigInteger &right, Operation operation );
     };
+
+
+    template<std::integral Integer> requires ( !std::same_as<Integer, bool> )
+    BigInteger::BigInteger( Integer value )
+    {
+        using Unsigned = std::make_unsigned_t<Integer>;
+        static_assert( std::numeric_limits<Unsigned>::digits <= std::numeric_limits<storage_type>::digits );
+
+        // Negating in unsigned arithmetic gives the magnitude even for the most negative value.
+        Unsigned magnitude = static_cast<Unsigned>( value );
+        if constexpr( std::is_signed_v<Integer> ) {
+            if( value < 0 ) {
+                negative = true;
+                magnitude = static_cast<Unsigned>( Unsigned( 0 ) - magnitude );
+            }
+        }
+        if( magnitude != 0 ) digits.push_back( magnitude );
+    }
     
 
+    // The free operators below take advantage of temporary operands. For example in `a + b + c`
+    // the result of `a + b` is a temporary, so its storage is reused for the final sum instead
+    // of being copied. Addition and multiplication are commutative so a temporary on either
+    // side can be reused.
+
     inline BigInteger operator+( const BigInteger &left, const BigInteger &right )
     {
         BigInteger temp( left );
@@ -91,6 +213,200 @@ namespace vtsu {
         return temp;
     }
 
+    inline BigInteger operator+( BigInteger &&left, const BigInteger &right )
+    {
+        left += right;
+        return std::move( left );
+    }
+
+    inline BigInteger operator+( const BigInteger &left, BigInteger &&right )
+    {
+        right += left;
+        return std::move( right );
+    }
+
+    inline BigInteger operator+( BigInteger &&left, BigInteger &&right )
+    {
+        left += right;
+        return std::move( left );
+    }
+
+
+    inline BigInteger operator-( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp -= right;
+        return temp;
+    }
+
+    inline BigInteger operator-( BigInteger &&left, const BigInteger &right )
+    {
+        left -= right;
+        return std::move( left );
+    }
+
+
+    inline BigInteger operator*( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp *= right;
+        return temp;
+    }
+
+    inline BigInteger operator*( BigInteger &&left, const BigInteger &right )
+    {
+        left *= right;
+        return std::move( left );
+    }
+
+    inline BigInteger operator*( const BigInteger &left, BigInteger &&right )
+    {
+        right *= left;
+        return std::move( right );
+    }
+
+    inline BigInteger operator*( BigInteger &&left, BigInteger &&right )
+    {
+        left *= right;
+        return std::move( left );
+    }
+
+
+    inline BigInteger operator/( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp /= right;
+        return temp;
+    }
+
+    inline BigInteger operator/( BigInteger &&left, const BigInteger &right )
+    {
+        left /= right;
+        return std::move( left );
+    }
+
+
+    inline BigInteger operator%( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp %= right;
+        return temp;
+    }
+
+    inline BigInteger operator%( BigInteger &&left, const BigInteger &right )
+    {
+        left %= right;
+        return std::move( left );
+    }
+
+
+    inline BigInteger operator&( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp &= right;
+        return temp;
+    }
+
+    inline BigInteger operator&( BigInteger &&left, const BigInteger &right )
+    {
+        left &= right;
+        return std::move( left );
+    }
+
+    inline BigInteger operator|( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp |= right;
+        return temp;
+    }
+
+    inline BigInteger operator|( BigInteger &&left, const BigInteger &right )
+    {
+        left |= right;
+        return std::move( left );
+    }
+
+    inline BigInteger operator^( const BigInteger &left, const BigInteger &right )
+    {
+        BigInteger temp( left );
+        temp ^= right;
+        return temp;
+    }
+
+    inline BigInteger operator^( BigInteger &&left, const BigInteger &right )
+    {
+        left ^= right;
+        return std::move( left );
+    }
+
+    inline BigInteger operator<<( const BigInteger &value, std::size_t count )
+    {
+        BigInteger temp( value );
+        temp <<= count;
+        return temp;
+    }
+
+    inline BigInteger operator<<( BigInteger &&value, std::size_t count )
+    {
+        value <<= count;
+        return std::move( value );
+    }
+
+    inline BigInteger operator>>( const BigInteger &value, std::size_t count )
+    {
+        BigInteger temp( value );
+        temp >>= count;
+        return temp;
+    }
+
+    inline BigInteger operator>>( BigInteger &&value, std::size_t count )
+    {
+        value >>= count;
+        return std::move( value );
+    }
+
+
+    //! Computes a * b + c without creating the product as a separate object.
+    /*!
+     * The product is added directly into the digits of `c`. Pass `c` with std::move to reuse its
+     * storage, as in `sum = fma( a, b, std::move( sum ) )`.
+     */
+    BigInteger fma( const BigInteger &a, const BigInteger &b, BigInteger c );
+
+
+    //! Computes the quotient and remainder of a division at the same time.
+    /*!
+     * This is faster than using both operator/ and operator% since the quotient and remainder
+     * are produced by the same computation.
+     *
+     * \returns A pair containing the quotient (first) and the remainder (second).
+     * \throws BigInteger::DivisionByZero if `divisor` is zero.
+     */
+    std::pair<BigInteger, BigInteger> divmod( const BigInteger &dividend, const BigInteger &divisor );
+
+    //! Computes (base**exponent) % modulus.
+    /*!
+     * The computation uses sliding window exponentiation. Odd moduli of moderate size use
+     * Montgomery reduction and all other moduli use Barrett reduction, so no divisions are done
+     * inside the main loop.
+     *
+     * The result is always in the range [0, modulus), even if `base` is negative.
+     *
+     * \throws BigInteger::DivisionByZero if `modulus` is zero.
+     * \throws std::domain_error if `exponent` or `modulus` is negative.
+     */
+    BigInteger pow_mod( const BigInteger &base, const BigInteger &exponent, const BigInteger &modulus );
+
+    //! Sets the number of threads used to multiply very large values.
+    /*!
+     * Products of more than a few hundred digits are split into independent pieces that are
+     * computed in parallel, and the largest products use a number theoretic transform that is
+     * also computed in parallel. By default the number of threads is the number of hardware
+     * threads. A thread count of one disables parallelism. This function must not be called
+     * while a multiplication is in progress in another thread.
+     */
+    void set_multiplication_threads( unsigned thread_count );
+
 }
 
 
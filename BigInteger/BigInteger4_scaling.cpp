@@ -0,0 +1,79 @@
+/*! \file   BigInteger4_scaling.cpp
+ *  \brief  A program that measures how BigInteger4 multiplication scales with thread count.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * For several operand sizes this program multiplies two random values using 1, 2, 4, ...
+ * threads (up to the number of hardware threads) and reports the time and the speedup over a
+ * single thread. The smaller sizes use Karatsuba's method and the larger ones use the number
+ * theoretic transform. Build with optimization for meaningful results. For example:
+ *
+ *     make BigInteger4_scaling CXXFLAGS="-std=c++20 -O2"
+ *
+ * The maximum number of threads to try can be given on the command line.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include "BigInteger4.hpp"
+
+using namespace std;
+
+string random_digits( size_t count, mt19937 &generator )
+{
+    uniform_int_distribution<int> digit( 0, 9 );
+    string result( count, '0' );
+    for( auto &ch : result ) {
+        ch = static_cast<char>( '0' + digit( generator ) );
+    }
+    result[0] = '1';
+    return result;
+}
+
+// Returns the time in seconds needed to compute x * y, using the best of several trials.
+double time_multiply( const vtsu::BigInteger &x, const vtsu::BigInteger &y )
+{
+    double best = 0.0;
+    for( int trial = 0; trial < 3; ++trial ) {
+        auto start = chrono::high_resolution_clock::now( );
+        vtsu::BigInteger product = x * y;
+        auto end = chrono::high_resolution_clock::now( );
+        chrono::duration<double> elapsed_seconds = end - start;
+        if( trial == 0 || elapsed_seconds.count( ) < best ) best = elapsed_seconds.count( );
+    }
+    return best;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned max_threads = thread::hardware_concurrency( );
+    if( argc > 1 ) max_threads = static_cast<unsigned>( atoi( argv[1] ) );
+    if( max_threads == 0 ) max_threads = 1;
+
+    mt19937 generator( 4 );
+    const size_t sizes[] = { 10'000, 100'000, 1'000'000, 4'000'000 };
+
+    cout << setw( 10 ) << "Digits" << setw( 10 ) << "Threads"
+         << setw( 14 ) << "Seconds" << setw( 10 ) << "Speedup" << "\n";
+    for( size_t size : sizes ) {
+        // Parsing uses multiplication too, so the operands are created with all threads.
+        vtsu::set_multiplication_threads( max_threads );
+        const vtsu::BigInteger x{ random_digits( size, generator ) };
+        const vtsu::BigInteger y{ random_digits( size, generator ) };
+
+        double single = 0.0;
+        for( unsigned threads = 1; threads <= max_threads; threads *= 2 ) {
+            vtsu::set_multiplication_threads( threads );
+            const double seconds = time_multiply( x, y );
+            if( threads == 1 ) single = seconds;
+            cout << setw( 10 ) << size << setw( 10 ) << threads
+                 << setw( 14 ) << fixed << setprecision( 6 ) << seconds
+                 << setw( 10 ) << setprecision( 2 ) << single / seconds << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
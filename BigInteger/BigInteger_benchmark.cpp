@@ -0,0 +1,282 @@
+/*! \file   BigInteger_benchmark.cpp
+ *  \brief  A program that compares the performance of the four BigInteger generations.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * All four generations define a class named vtsu::BigInteger, so they can't be used in the same
+ * program. Instead this file is compiled once for each generation, with BIGINTEGER_GENERATION
+ * set to 1, 2, 3, or 4. The Makefile does this to create BigInteger1_benchmark through
+ * BigInteger4_benchmark. Build with optimization for meaningful results. For example:
+ *
+ *     make clean
+ *     make benchmarks CXXFLAGS="-std=c++20 -O2"
+ *
+ * Each program measures addition, multiplication, parsing (construction from a decimal string),
+ * and printing for operands of 1, 10, 100, ... up to one million limbs. A "limb" is 64 bits
+ * regardless of how the generation stores its digits, so the same row in the output of each
+ * program refers to the same values. Along with the time, the number of heap allocations done
+ * by each operation is reported. The allocations are counted by replacing the global operator
+ * new. Note that printing includes the allocations done by the string stream. For BigInteger2
+ * and BigInteger3, addition is also measured with the sum's digits taken from an Arena.
+ *
+ * Operations that a generation doesn't support are shown with a dash. Sizes that would take too
+ * long (based on the time needed for the previous size) are also skipped. The largest size and
+ * the time limit (in seconds) can be given on the command line.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if BIGINTEGER_GENERATION == 1
+    #include "BigInteger1.hpp"
+#elif BIGINTEGER_GENERATION == 2
+    #include "Arena.hpp"
+    #include "BigInteger2.hpp"
+#elif BIGINTEGER_GENERATION == 3
+    #include "Arena.hpp"
+    #include "BigInteger3.hpp"
+#elif BIGINTEGER_GENERATION == 4
+    #include "BigInteger4.hpp"
+#else
+    #error "BIGINTEGER_GENERATION must be defined as 1, 2, 3, or 4"
+#endif
+
+using namespace std;
+
+// What each generation can do. BigInteger1 holds at most 128 decimal digits (six limbs).
+// Only BigInteger3 and BigInteger4 can multiply. BigInteger3 can't print its values in decimal
+// (it prints each base 2**16 digit as a character), so timing it would be meaningless.
+#if BIGINTEGER_GENERATION == 1
+constexpr size_t maximum_limbs = 6;
+#else
+constexpr size_t maximum_limbs = static_cast<size_t>( -1 );
+#endif
+constexpr bool can_multiply = ( BIGINTEGER_GENERATION >= 3 );  // See also the #if in main( ).
+constexpr bool can_print    = ( BIGINTEGER_GENERATION != 3 );
+constexpr bool has_arena    = ( BIGINTEGER_GENERATION == 2 || BIGINTEGER_GENERATION == 3 );
+
+
+// Counting Allocator
+// ==================
+
+// The benchmarked code might use threads (BigInteger4 does) so the count is atomic.
+static atomic<size_t> allocation_count{ 0 };
+
+void *operator new( size_t size )
+{
+    allocation_count.fetch_add( 1, memory_order_relaxed );
+    if( void *p = malloc( size == 0 ? 1 : size ) ) return p;
+    throw bad_alloc( );
+}
+
+void *operator new[]( size_t size )
+{
+    return operator new( size );
+}
+
+void operator delete( void *p ) noexcept
+{
+    free( p );
+}
+
+void operator delete[]( void *p ) noexcept
+{
+    free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept
+{
+    free( p );
+}
+
+void operator delete[]( void *p, size_t ) noexcept
+{
+    free( p );
+}
+
+
+// Measurement
+// ===========
+
+struct Measurement {
+    double seconds;      // Time for one operation.
+    double allocations;  // Heap allocations for one operation.
+};
+
+// Runs `operation` repeatedly for at least a short while and returns the average cost.
+template<typename Operation>
+Measurement measure( Operation operation )
+{
+    using clock = chrono::steady_clock;
+    const chrono::duration<double> minimum_time( 0.2 );
+
+    const size_t allocations_before = allocation_count.load( );
+    const auto start = clock::now( );
+    size_t iterations = 0;
+    chrono::duration<double> elapsed;
+    do {
+        operation( );
+        ++iterations;
+        elapsed = clock::now( ) - start;
+    } while( elapsed < minimum_time );
+    const size_t allocations = allocation_count.load( ) - allocations_before;
+    return { elapsed.count( ) / iterations, static_cast<double>( allocations ) / iterations };
+}
+
+
+// Returns a random string of decimal digits for a value with the given number of 64 bit limbs.
+string random_digits( size_t limbs, mt19937 &generator )
+{
+    const size_t count = static_cast<size_t>( ceil( 64.0 * limbs * log10( 2.0 ) ) ) - 1;
+    uniform_int_distribution<int> digit( 0, 9 );
+    string result( count, '0' );
+    for( auto &ch : result ) {
+        ch = static_cast<char>( '0' + digit( generator ) );
+    }
+    result[0] = '1';
+    return result;
+}
+
+
+// Keeps track of which sizes are worth trying for one operation.
+class SizeLimiter {
+public:
+    explicit SizeLimiter( double time_limit ) : time_limit( time_limit ) { }
+
+    //! Returns true if an operation on `limbs` limbs is expected to take too long.
+    /*!
+     * The time for the previous size is scaled by the size ratio (all the operations take at
+     * least linear time) or by the growth in time seen between the previous two sizes,
+     * whichever is larger. This assumes the sizes grow by the same factor each time.
+     */
+    bool too_long( size_t limbs ) const
+    {
+        if( previous_limbs == 0 ) return false;
+        double scale = static_cast<double>( limbs ) / previous_limbs;
+        if( earlier_seconds > 0.0 && previous_seconds / earlier_seconds > scale ) {
+            scale = previous_seconds / earlier_seconds;
+        }
+        return previous_seconds * scale > time_limit;
+    }
+
+    void record( size_t limbs, double seconds )
+    {
+        earlier_seconds  = previous_seconds;
+        previous_limbs   = limbs;
+        previous_seconds = seconds;
+    }
+
+private:
+    double time_limit;
+    size_t previous_limbs   = 0;
+    double previous_seconds = 0.0;
+    double earlier_seconds  = 0.0;
+};
+
+
+void print_row( const char *operation, size_t limbs, size_t digits, const Measurement *result )
+{
+    cout << setw( 4 ) << BIGINTEGER_GENERATION << setw( 10 ) << operation
+         << setw( 10 ) << limbs << setw( 10 ) << digits;
+    if( result == nullptr ) {
+        cout << setw( 16 ) << "-" << setw( 14 ) << "-" << "\n";
+    }
+    else {
+        cout << setw( 16 ) << scientific << setprecision( 3 ) << result->seconds
+             << setw( 14 ) << fixed << setprecision( 1 ) << result->allocations << "\n";
+    }
+}
+
+
+int main( int argc, char **argv )
+{
+    size_t largest     = 1'000'000;
+    double time_limit  = 10.0;
+    if( argc > 1 ) largest    = static_cast<size_t>( atol( argv[1] ) );
+    if( argc > 2 ) time_limit = atof( argv[2] );
+
+    mt19937 generator( 33 );
+    const char *operations[] = { "add", "multiply", "parse", "print", "add/arena" };
+    SizeLimiter limiters[] = {
+        SizeLimiter( time_limit ), SizeLimiter( time_limit ), SizeLimiter( time_limit ),
+        SizeLimiter( time_limit ), SizeLimiter( time_limit )
+    };
+
+    // Do a small multiplication first so that one-time setup (such as the creation of a thread
+    // pool) isn't counted against the first measurement.
+#if BIGINTEGER_GENERATION >= 3
+    vtsu::BigInteger warm_up{ "12345678901234567890" };
+    warm_up *= warm_up;
+#endif
+
+    cout << setw( 4 ) << "Gen" << setw( 10 ) << "Operation" << setw( 10 ) << "Limbs"
+         << setw( 10 ) << "Digits" << setw( 16 ) << "Seconds/op" << setw( 14 ) << "Allocs/op" << "\n";
+    for( size_t limbs = 1; limbs <= largest; limbs *= 10 ) {
+        const string x_text = random_digits( limbs, generator );
+        const string y_text = random_digits( limbs, generator );
+        const bool in_range = ( limbs <= maximum_limbs );
+
+        // The operands are only created if some operation needs them.
+        vtsu::BigInteger x;
+        vtsu::BigInteger y;
+        bool have_operands = false;
+
+        for( int op = 0; op < 5; ++op ) {
+            const bool supported = in_range &&
+                ( op != 1 || can_multiply ) && ( op != 3 || can_print ) && ( op != 4 || has_arena ) &&
+                !limiters[op].too_long( limbs );
+            if( !supported ) {
+                print_row( operations[op], limbs, x_text.size( ), nullptr );
+                continue;
+            }
+            if( !have_operands ) {
+                x = vtsu::BigInteger{ x_text };
+                y = vtsu::BigInteger{ y_text };
+                have_operands = true;
+            }
+
+            vtsu::BigInteger result;
+            Measurement m{ };
+            switch( op ) {
+            case 0:
+                m = measure( [&] { result = x + y; } );
+                break;
+            case 1:
+            #if BIGINTEGER_GENERATION >= 3
+                m = measure( [&] { result = x * y; } );
+            #endif
+                break;
+            case 2:
+                m = measure( [&] { result = vtsu::BigInteger{ x_text }; } );
+                break;
+            case 3:
+                m = measure( [&] { ostringstream out; out << x; } );
+                break;
+            case 4:
+            #if BIGINTEGER_GENERATION == 2 || BIGINTEGER_GENERATION == 3
+                // The same addition as above, but the sum is a temporary whose digits come from
+                // an arena over a buffer that is reused each time.
+                {
+                    vector<unsigned char> buffer( 4 * x_text.size( ) + 4096 );
+                    m = measure( [&] {
+                        vtsu::Arena arena( buffer.data( ), buffer.size( ) );
+                        vtsu::BigInteger sum = x + y;
+                    } );
+                }
+            #endif
+                break;
+            }
+            limiters[op].record( limbs, m.seconds );
+            print_row( operations[op], limbs, x_text.size( ), &m );
+        }
+    }
+    return EXIT_SUCCESS;
+}
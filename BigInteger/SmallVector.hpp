@@ -0,0 +1,194 @@
+/*! \file   SmallVector.hpp
+ *  \brief  A vector-like container that stores a few elements without using the heap.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * A SmallVector holds up to InlineCapacity elements inside the object itself. Only when more
+ * elements are added does it allocate memory dynamically, after which it behaves like an
+ * ordinary vector. Programs that create many short-lived containers, most of which remain
+ * small, can avoid nearly all memory allocation this way.
+ *
+ * Only the parts of the std::vector interface needed by BigInteger are provided. Elements must
+ * be trivially copyable so they can be moved around with simple copies and so the storage can
+ * be left uninitialized until it is used.
+ */
+
+#ifndef SMALLVECTOR_HPP
+#define SMALLVECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+
+namespace vtsu {
+
+    template<typename T, std::size_t InlineCapacity>
+        requires std::is_trivially_copyable_v<T> && ( InlineCapacity > 0 )
+    class SmallVector {
+    public:
+        using value_type     = T;
+        using size_type      = std::size_t;
+        using iterator       = T *;
+        using const_iterator = const T *;
+
+        SmallVector( ) noexcept :
+            storage{ inline_storage }, count{ 0 }, space{ InlineCapacity }
+        { }
+
+        //! Creates a SmallVector holding `n` value-initialized (zero) elements.
+        explicit SmallVector( size_type n ) : SmallVector( )
+            { resize( n ); }
+
+        SmallVector( const T *first, const T *last ) : SmallVector( )
+            { assign( first, last ); }
+
+        SmallVector( std::initializer_list<T> values ) : SmallVector( )
+            { assign( values.begin( ), values.end( ) ); }
+
+        SmallVector( const SmallVector &other ) : SmallVector( )
+            { assign( other.begin( ), other.end( ) ); }
+
+        SmallVector( SmallVector &&other ) noexcept : SmallVector( )
+            { take( other ); }
+
+        SmallVector &operator=( const SmallVector &other )
+        {
+            if( this != &other ) assign( other.begin( ), other.end( ) );
+            return *this;
+        }
+
+        SmallVector &operator=( SmallVector &&other ) noexcept
+        {
+            if( this != &other ) {
+                release( );
+                take( other );
+            }
+            return *this;
+        }
+
+        ~SmallVector( )
+            { release( ); }
+
+        // Element access.
+        T       &operator[]( size_type index )       { return storage[index]; }
+        const T &operator[]( size_type index ) const { return storage[index]; }
+        T       &back( )       { return storage[count - 1]; }
+        const T &back( ) const { return storage[count - 1]; }
+        T       *data( )       noexcept { return storage; }
+        const T *data( ) const noexcept { return storage; }
+
+        // Iterators are simply pointers.
+        iterator       begin( )       noexcept { return storage; }
+        const_iterator begin( ) const noexcept { return storage; }
+        iterator       end( )         noexcept { return storage + count; }
+        const_iterator end( )   const noexcept { return storage + count; }
+
+        // Capacity.
+        bool      empty( )    const noexcept { return count == 0; }
+        size_type size( )     const noexcept { return count; }
+        size_type capacity( ) const noexcept { return space; }
+
+        //! Returns true if the elements are stored inside the object (no heap memory is used).
+        bool is_inline( ) const noexcept
+            { return storage == inline_storage; }
+
+        void reserve( size_type n )
+            { if( n > space ) reallocate( n ); }
+
+        // Modifiers.
+        void clear( ) noexcept
+            { count = 0; }
+
+        void push_back( const T &value )
+        {
+            // Copy the value first in case it refers to an element of this SmallVector.
+            const T copy = value;
+            if( count == space ) reallocate( std::max( 2 * space, InlineCapacity ) );
+            storage[count++] = copy;
+        }
+
+        void pop_back( )
+            { --count; }
+
+        void resize( size_type n )
+            { resize( n, T( ) ); }
+
+        void resize( size_type n, const T &value )
+        {
+            // Grow geometrically so that repeatedly increasing the size by a little is cheap.
+            if( n > space ) reallocate( std::max( n, 2 * space ) );
+            if( n > count ) std::fill( storage + count, storage + n, value );
+            count = n;
+        }
+
+        void assign( size_type n, const T &value )
+        {
+            clear( );
+            resize( n, value );
+        }
+
+        //! Replaces the contents with [first, last), which must not refer into this SmallVector.
+        void assign( const T *first, const T *last )
+        {
+            const size_type n = static_cast<size_type>( last - first );
+            if( n > space ) {
+                // The old elements are not needed, so don't bother copying them.
+                count = 0;
+                release( );
+                storage = new T[n];
+                space = n;
+            }
+            std::copy( first, last, storage );
+            count = n;
+        }
+
+    private:
+        // INVARIANT: `storage` points either at `inline_storage` (in which case `space` is
+        // InlineCapacity) or at a dynamically allocated array of `space` elements. The first
+        // `count` elements of that array are the elements of the SmallVector.
+        T        *storage;
+        size_type count;
+        size_type space;
+        T         inline_storage[InlineCapacity];
+
+        // Moves the elements to a dynamically allocated array of the given size.
+        void reallocate( size_type new_space )
+        {
+            T *new_storage = new T[new_space];
+            std::copy( storage, storage + count, new_storage );
+            release( );
+            storage = new_storage;
+            space = new_space;
+        }
+
+        // Frees any dynamically allocated array and returns to the inline storage. This does
+        // not change `count`; the caller must deal with that.
+        void release( ) noexcept
+        {
+            if( !is_inline( ) ) delete [] storage;
+            storage = inline_storage;
+            space = InlineCapacity;
+        }
+
+        // Takes the elements of `other`, which must be using its inline storage or have its
+        // array stolen. Either way `other` is left empty. This object must be empty and using
+        // its inline storage.
+        void take( SmallVector &other ) noexcept
+        {
+            if( other.is_inline( ) ) {
+                std::copy( other.inline_storage, other.inline_storage + other.count, inline_storage );
+            }
+            else {
+                storage = other.storage;
+                space = other.space;
+                other.storage = other.inline_storage;
+                other.space = InlineCapacity;
+            }
+            count = other.count;
+            other.count = 0;
+        }
+    };
+
+}
+
+#endif
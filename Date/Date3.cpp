@@ -3,236 +3,177 @@
  *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
  */
 
+#include <charconv>
+#include <cstddef>
 #include <ctime>
-#include <iomanip>
 #include <iostream>
-#include <regex>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "Date3.hpp"
+#include "DigitChars.hpp"
 
 using namespace std;
 
 namespace vtsu {
 
-    // Private Methods
-    // ===============
-
-    bool Date::is_leap( ) const
-    {
-        bool result = false;
-
-        if(           ( year %   4 == 0 ) ) result = true;
-        if( result && ( year % 100 == 0 ) ) result = false;
-        if(!result && ( year % 400 == 0 ) ) result = true;
-
-        return result;
-    }
-
-
-    int Date::month_length( ) const
-    {
-        // Lookup table gives number of days in each month.
-        static const int month_lengths[] = {
-            31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-        };
-
-        int length = month_lengths[month - 1];
-
-        // Now perhaps make a correction if the month is February.
-        if( month == 2 && is_leap( ) ) length++;
-
-        return length;
-    }
-
+    namespace {
+
+        // Writes exactly date_chars characters to `text`. There must be room for them.
+        inline void write_date( char *text, const Date &the_date )
+        {
+            const unsigned year = static_cast<unsigned>( the_date.get_year( ) );
+            digits::write_pair( text, year / 100U );
+            digits::write_pair( text + 2, year % 100U );
+            text[4] = '-';
+            digits::write_pair( text + 5, static_cast<unsigned>( the_date.get_month( ) ) );
+            text[7] = '-';
+            digits::write_pair( text + 8, static_cast<unsigned>( the_date.get_day( ) ) );
+        }
 
-    // This method has to deal with the fact that the number of days in each month is different.
-    // Furthermore, the number of days in February is a function of the year. Notice that this
-    // method does not attempt to restore the state of a Date object if an exception is thrown.
-    // That is the responsibility of the caller.
-    void Date::next( )
-    {
-        // Try incrementing the day. If it overflows the month, make a correction, etc.
-        if( ++day > month_length( ) ) {
-            day = 1;
-            if( ++month > 12 ) {
-                month = 1;
-                ++year;
-                if( year > maximum_year )
-                    throw OutOfRange( "Date overflow in Date::next( )" );
+        // Checks, at compile time, that the first and last days of every month in the allowed
+        // range convert to serial numbers and back again correctly. The estimates made by
+        // Date::set_serial( ) are most likely to be wrong near those days.
+        constexpr bool check_calendar( )
+        {
+            for( int year = Date::minimum_year; year <= Date::maximum_year; ++year ) {
+                for( int month = 1; month <= 12; ++month ) {
+                    const int first = days_from_civil( year, month, 1 );
+                    const int last  = days_from_civil( year + month / 12, month % 12 + 1, 1 ) - 1;
+                    const Date first_date = Date::from_serial( first );
+                    const Date last_date  = Date::from_serial( last );
+                    if( Date( year, month, 1 ).get_serial( ) != first || first_date.get_year( ) != year ||
+                        first_date.get_month( ) != month || first_date.get_day( ) != 1 ||
+                        last_date.get_year( ) != year || last_date.get_month( ) != month ||
+                        last_date.get_day( ) != last - first + 1 )
+                        return false;
+                }
             }
+            return true;
         }
+
+        static_assert( check_calendar( ) );
+        static_assert( Date( 1970, 1, 1 ).get_serial( ) == 0 );
+        static_assert( difference( Date( Date::maximum_year, 12, 31 ), Date( ) ) == 91'310 );
     }
 
+    // Private Methods
+    // ===============
 
-    // This method works similarly to Date::next().
-    void Date::previous( )
+    // Strings have the form YYYY-MM-DD or the form MM/DD/YYYY. In the second case, the month
+    // and day can be one or two digits. The year must always be four digits. This accepts exactly
+    // the strings matched by the regular expression
+    //
+    //     ((\d{4})-(\d{2})-(\d{2}))|((\d{1,2})/(\d{1,2})/(\d{4}))
+    //
+    // that was used in earlier versions. Checking the characters directly is much faster than
+    // using a regular expression, and it doesn't allocate memory.
+    bool Date::parse_fields( string_view date_string, int &year, int &month, int &day ) noexcept
     {
-        bool fix_day = false;
-
-        // Try decrementing the day.
-        if( --day < 1 ) {
-            fix_day = true;
-            if( --month < 1 ) {
-                month = 12;
-                --year;
-                if( year < minimum_year )
-                    throw OutOfRange( "Date underflow in Date::previous( )" );
-            }
+        const char *text = date_string.data( );
+        const size_t length = date_string.size( );
+
+        if( length == 10 && text[4] == '-' && text[7] == '-' ) {
+            return digits::parse_fixed( text, 4, year ) &&
+                   digits::parse_fixed( text + 5, 2, month ) &&
+                   digits::parse_fixed( text + 8, 2, day );
         }
 
-        // If we wrapped over a month boundary, set the day to the last day of the new month.
-        if( fix_day ) day = month_length( );
+        // The month and day each end at the first slash after them.
+        const size_t first_slash = date_string.find( '/' );
+        if( first_slash != 1 && first_slash != 2 ) return false;
+        const size_t second_slash = date_string.find( '/', first_slash + 1 );
+        const size_t day_length = second_slash - first_slash - 1;
+        if( second_slash == string_view::npos || day_length < 1 || day_length > 2 ) return false;
+        if( length - second_slash - 1 != 4 ) return false;
+        return digits::parse_fixed( text, static_cast<int>( first_slash ), month ) &&
+               digits::parse_fixed( text + first_slash + 1, static_cast<int>( day_length ), day ) &&
+               digits::parse_fixed( text + second_slash + 1, 4, year );
     }
 
 
     // Public Methods
     // ==============
 
-    Date::Date( )
-    {
-        year  = minimum_year;
-        month = 1;
-        day   = 1;
-    }
-
-
-    Date::Date( int year, int month, int day)
+    Date::Date( string_view date_string )
     {
-        set( year, month, day );
+        set( date_string );
     }
 
 
-    void Date::set( int year, int month, int day )
+    void Date::set( string_view date_string )
     {
-        // First check if the date is out of range or definitely invalid.
-        if( year < minimum_year || year > maximum_year )
-            throw OutOfRange( "Date out of range in Date::set( int, int, int )" );
+        int incoming_year;
+        int incoming_month;
+        int incoming_day;
 
-        if( month < 1 || month > 12 )
-            throw Invalid( "Invalid month in Date::set( int, int, int )" );
-
-        if( day < 1 || day > 31 )
-            throw Invalid( "Invalid day in Date::set( int, int, int )" );
-
-        // Back up this Date's current state.
-        Date backup = *this;
-
-        // Install the new date information.
-        this->year = year; this->month = month; this->day = day;
-
-        // Check if the new day is valid in the context of the date. If not, restore the
-        // original state.
-        if ( this->day > month_length( ) ) {
-            *this = backup;
-            throw Invalid( "Invalid day in Date::set( int, int, int )" );
-        }
-    }
-
-
-    void Date::set( const string &date_string )
-    {
-        // The regular expression below matches a string of the form YYYY-MM-DD or of the form
-        // MM/DD/YYYY. In the second case, the month and day can be one or two digits. The year
-        // must always be four digits.
-        regex  date_matcher{ R"(((\d{4})-(\d{2})-(\d{2}))|((\d{1,2})/(\d{1,2})/(\d{4})))" };
-        smatch matches;
-
-        // Try to match the entire string.
-        if( !regex_match( date_string, matches, date_matcher ) ) {
-            throw Invalid( "Invalid date string format in Date::set( const std::string & )" );
+        if( !parse_fields( date_string, incoming_year, incoming_month, incoming_day ) ) {
+            throw Invalid( "Invalid date string format in Date::set( std::string_view )" );
         }
 
-        // Which alternative matched?
-        if( matches[1].matched ) {
-            // The first alternative matched. Extract the sub-matches.
-            int incoming_year  = stoi( matches[2] );
-            int incoming_month = stoi( matches[3] );
-            int incoming_day   = stoi( matches[4] );
-
-            // Delegate to Date::set( int, int, int ) the task of checking the values and
-            // throwing exceptions if necessary.
-            set( incoming_year, incoming_month, incoming_day );
-            return;
-        }
-        else if( matches[5].matched ) {
-            // The second alternative matched. Extract the sub-matches.
-            int incoming_month = stoi( matches[6] );
-            int incoming_day   = stoi( matches[7] );
-            int incoming_year  = stoi( matches[8] );
-
-            // Delegate to Date::set( int, int, int ) the task of checking the values and
-            // throwing exceptions if necessary.
-            set( incoming_year, incoming_month, incoming_day );
-            return;
-        }
-        else {
-            // This should never happen.
-            throw logic_error( "Internal error in Date::set( const std::string & )" );
-        }
+        // Delegate to Date::set( int, int, int ) the task of checking the values and throwing
+        // exceptions if necessary.
+        set( incoming_year, incoming_month, incoming_day );
     }
 
 
-    void Date::advance( long delta )
+    Date::Status Date::try_set( string_view date_string ) noexcept
     {
-        long count;
-
-        // If delta == 0 we're done already.
-        if( delta == 0 ) return;
-
-        // Back up this Date's current state.
-        Date backup = *this;
+        int incoming_year;
+        int incoming_month;
+        int incoming_day;
 
-        try {
-            // If we're trying to step forward...
-            if( delta >  0 ) {
-                for( count = delta; count > 0; count-- ) next( );
-            }
-
-            // We're trying to step backward...
-            else {
-                for( count = -delta; count > 0; count-- ) previous( );
-            }
+        if( !parse_fields( date_string, incoming_year, incoming_month, incoming_day ) ) {
+            return Status::invalid;
         }
-
-        // If we go off the end of the allowed range, restore the original state and rethrow.
-        catch( Date::OutOfRange & ) {
-            *this = backup;
-            throw;
+        const Status result = validate( incoming_year, incoming_month, incoming_day );
+        if( result == Status::ok ) {
+            year  = incoming_year;
+            month = incoming_month;
+            day   = incoming_day;
+            serial = serial_of( year, month, day );
         }
+        return result;
     }
 
 
     // Free Functions
     // ==============
 
-    long difference( const Date &future, const Date &past )
+    size_t parse_dates( span<const string_view> date_strings, span<Date> dates, span<Date::Status> statuses )
     {
-        long result = 0;
+        if( dates.size( ) < date_strings.size( ) || statuses.size( ) < date_strings.size( ) )
+            throw invalid_argument( "Output spans too small in parse_dates( )" );
+
+        size_t failures = 0;
+        for( size_t i = 0; i < date_strings.size( ); ++i ) {
+            statuses[i] = dates[i].try_set( date_strings[i] );
+            if( statuses[i] != Date::Status::ok ) ++failures;
+        }
+        return failures;
+    }
 
-        // Handle the simple case first.
-        if( future == past ) return 0;
 
-        // Make copies of the parameters that I can change.
-        Date my_future{ future };
-        Date my_past{ past };
+    to_chars_result to_chars( char *first, char *last, const Date &the_date ) noexcept
+    {
+        if( last - first < static_cast<ptrdiff_t>( date_chars ) ) return { last, errc::value_too_large };
+        write_date( first, the_date );
+        return { first + date_chars, errc{ } };
+    }
 
-        // If my_past is small, advance it until it matches my_future.
-        // This will never throw an exception because both dates are valid.
-        while( my_future > my_past ) {
-            my_past.advance( 1 );
-            result++;
-        }
 
-        // If my_future is small, advance it until it matches my_past.
-        // This will never throw an exception because both dates are valid.
-        while( my_past > my_future ) {
-            my_future.advance( 1 );
-            result--;
+    void format_dates( span<const Date> dates, string &text, char separator )
+    {
+        const size_t original_size = text.size( );
+        text.resize( original_size + dates.size( ) * ( date_chars + 1 ) );
+        char *p = text.data( ) + original_size;
+        for( const Date &the_date : dates ) {
+            write_date( p, the_date );
+            p[date_chars] = separator;
+            p += date_chars + 1;
         }
-
-        return result;
     }
 
 
@@ -249,7 +190,7 @@ namespace vtsu {
         // field.
         auto print_fill = []( ostream &output, char fill, int width ) -> void {
             for( int i = 10; i < width; ++i ) {
-                output << fill;
+                output.put( fill );
             }
         };
 
@@ -265,12 +206,11 @@ namespace vtsu {
             print_fill( output, original_fill, original_width );
         }
 
-        // Print the actual Date object.
-        output << setfill( '0' );
-        output << setw( 4 ) << the_date.get_year( )  << '-';
-        output << setw( 2 ) << the_date.get_month( ) << '-';
-        output << setw( 2 ) << the_date.get_day( );
-        output << setfill( original_fill );
+        // Print the actual Date object. Formatting it into a buffer first and writing the
+        // buffer all at once is much faster than inserting each field with its own width.
+        char buffer[date_chars];
+        write_date( buffer, the_date );
+        output.write( buffer, date_chars );
 
         // If we are not trying to right justify (meaning we are being explicitly asked to left
         // justify OR no specific justification is requested), print the caller's fill character
@@ -287,7 +227,7 @@ namespace vtsu {
         string date_string;
 
         // Get a single word from the input stream. Delegate the problem of parsing it and
-        // checking it to the Date::set( const string & ) method. If Date::set( const string &
+        // checking it to the Date::set( std::string_view ) method. If Date::set( std::string_view
         // ) throws an exception, 'the_date' will not be changed.
 
         input >> date_string;
@@ -11,18 +11,70 @@
  * + The inline accessor methods are now defined inside the class body.
  * + The relational operators are now generated from the spaceship operator.
  * + A lambda expression is used in the implementation of operator<<( ) as a demonstration.
+ * + Each Date also holds its serial day number, making advance( ), difference( ), and the
+ *   relational operators O(1) instead of proportional to the number of days involved.
+ * + Strings are parsed without regular expressions, and many strings can be parsed at once
+ *   with parse_dates( ), which reports errors with status codes instead of exceptions.
+ * + Validation and conversions between serial numbers and years, months, and days use tables
+ *   computed at compile time. The methods that don't involve strings are constexpr, so Dates
+ *   can be constants that are computed at compile time.
+ * + Dates can be written into character buffers with to_chars( ) and format_dates( ), which
+ *   are much faster than the stream insertion operator (which now uses to_chars( ) itself).
  */
 
 #ifndef DATE_HPP
 #define DATE_HPP
 
+#include <array>
+#include <charconv>
 #include <compare>     // Needed for spaceship operator.
+#include <cstddef>
 #include <iosfwd>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace vtsu {
 
+    // Calendar Arithmetic
+    // ===================
+
+    // These functions convert between a (proleptic Gregorian) year, month, and day and the
+    // number of days since January 1, 1970 using closed formulas instead of loops. They are
+    // from Howard Hinnant's paper "chrono-Compatible Low-Level Date Algorithms." The idea is
+    // to shift the start of the year to March 1 so that the leap day is the last day of the
+    // year, and then to count whole 400 year "eras" (of 146,097 days each) and the years,
+    // months, and days within an era. The day counts are the same as those used by
+    // std::chrono::sys_days and Date::get_serial( ).
+
+    //! Returns the number of days from January 1, 1970 to the given date.
+    constexpr int days_from_civil( int year, int month, int day )
+    {
+        year -= ( month <= 2 );
+        const int era = ( year >= 0 ? year : year - 399 ) / 400;
+        const int year_of_era  = year - era * 400;                                // [0, 399]
+        const int day_of_year  = ( 153 * ( month + ( month > 2 ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+        const int day_of_era   = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return era * 146097 + day_of_era - 719468;
+    }
+
+    //! Converts a number of days since January 1, 1970 to a year, month, and day.
+    constexpr void civil_from_days( int serial, int &year, int &month, int &day )
+    {
+        serial += 719468;
+        const int era = ( serial >= 0 ? serial : serial - 146096 ) / 146097;
+        const int day_of_era  = serial - era * 146097;                            // [0, 146096]
+        const int year_of_era =
+            ( day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096 ) / 365;
+        const int day_of_year = day_of_era - ( 365 * year_of_era + year_of_era / 4 - year_of_era / 100 );
+        const int shifted_month = ( 5 * day_of_year + 2 ) / 153;                  // [0, 11], March is 0.
+        day   = day_of_year - ( 153 * shifted_month + 2 ) / 5 + 1;
+        month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+        year  = year_of_era + era * 400 + ( month <= 2 );
+    }
+
+
     //! Class representing calendar dates.
     /*!
      * Date objects handle dates between Jan 1, 1950 and Dec 31, 2199. Any attempt to set a Date
@@ -61,6 +113,12 @@ namespace vtsu {
                 Invalid( const std::string &message ) : std::runtime_error( message ) { }
         };
 
+        //! The result of an operation that reports errors without throwing an exception.
+        /*!
+         * The values other than `ok` correspond to the exceptions OutOfRange and Invalid.
+         */
+        enum class Status { ok, out_of_range, invalid };
+
         static const int minimum_year = 1950;
         static const int maximum_year = 2199;
 
@@ -69,7 +127,7 @@ namespace vtsu {
          * This constructor initializes the Date to the minimum date of January 1,
          * Date::minimum_year.
          */
-        Date( );
+        constexpr Date( );
 
         //! Initialize to an arbitrary date.
         /*!
@@ -84,7 +142,7 @@ namespace vtsu {
          * considering the leap year rules. In cases where a Date is constructed with invalid
          * values *and* an out of range year, the OutOfRange exception is thrown.
          */
-        Date( int year, int month, int day );
+        constexpr Date( int year, int month, int day );
 
         //! Initialize using a string representation of a date.
         /*! 
@@ -94,7 +152,7 @@ namespace vtsu {
          * cases where a Date is constructed with invalid values *and* an out of range year,
          * the OutOfRange exception is thrown.
          */
-        explicit Date( const std::string &date_string );
+        explicit Date( std::string_view date_string );
 
         //! Set an existing Date to a new date.
         /*!
@@ -110,7 +168,7 @@ namespace vtsu {
          * considering the leap year rules. In cases where a Date is constructed with invalid
          * values *and* an out of range year, the OutOfRange exception is thrown.
          */
-        void set( int year, int month, int day );
+        constexpr void set( int year, int month, int day );
 
         //! Set an existing Date to a new date using a string representation of a date.
         /*!
@@ -122,37 +180,59 @@ namespace vtsu {
          * cases where a Date is constructed with invalid values *and* an out of range year, the
          * OutOfRange exception is thrown.
          */
-        void set( const std::string &date_string );
+        void set( std::string_view date_string );
+
+        //! Set an existing Date to a new date using a string, without throwing exceptions.
+        /*!
+         * This is the same as set( std::string_view ) except that errors are reported with the
+         * return value. The Date is only changed if the result is Status::ok.
+         */
+        Status try_set( std::string_view date_string ) noexcept;
 
         //! Returns the year of this Date (range Date::minimum_year .. Date::maximum_year).
-        int get_year( ) const
+        constexpr int get_year( ) const
             { return year; }
 
         //! Returns the month of this Date (in the range 1 .. 12).
-        int get_month( ) const
+        constexpr int get_month( ) const
             { return month; }
 
         //! Returns the day of this Date (in the range range 1 .. 31).
-        int get_day( ) const
+        constexpr int get_day( ) const
             { return day; }
 
+        //! Returns the number of days from January 1, 1970 to this Date.
+        /*!
+         * Dates before 1970 have negative serial numbers. Serial numbers count days in the same
+         * way as std::chrono::sys_days.
+         */
+        constexpr int get_serial( ) const
+            { return serial; }
+
+        //! Returns the Date with the given serial day number (see get_serial( )).
+        /*!
+         * \throws OutOfRange if the Date would be outside the allowed range.
+         */
+        static constexpr Date from_serial( long serial );
+
         //! Advance the date by a given number of days.
         /*!
          * This method modifies the Date in-place. If delta is negative this function will move
-         * the date backwards.
+         * the date backwards. It takes constant time regardless of the size of delta.
          *
          * \param delta The number of days to advance the date. Negative values are allowed.
          * 
          * \throws OutOfRange if this method would generate a date outside the allowed range. In
          * that case, the original Date object is left unchanged.
          */
-        void advance( long delta = 1 );
+        constexpr void advance( long delta = 1 );
 
         // The "spaceship" operator is used to generate all the relational operators. The use of
         // 'default' asks the compiler to automatically generate the spaceship operator itself
         // (which isn't required; you could implement the spaceship operator manually if
         // necessary). This is works here because all the data members of Date are comparable
-        // via '<=>' and they are declared in an appropriate order in the class definition.
+        // via '<=>' and they are declared in an appropriate order in the class definition. In
+        // fact, the serial number alone decides the result.
         //
         // In general, the spaceship operator returns a std::strong_ordering object. This object
         // can be compared to zero to determine the relationship between the two operands. The
@@ -161,16 +241,26 @@ namespace vtsu {
 
     private:
 
-        // This representation makes Date I/O easy, but Date computations awkward. The order in
-        // which these members appear is required by the spaceship operator's default
-        // implementation.
+        // The serial number makes Date computations easy, and the year, month, and day make Date
+        // I/O easy. Both are kept so that neither needs to be computed from the other except
+        // when a Date changes. The order in which these members appear is required by the
+        // spaceship operator's default implementation.
+        int serial;
         int year, month, day;
 
         // Private Methods
-        bool is_leap( ) const;       // Return true if the current year is a leap year.
-        int  month_length( ) const;  // Return the number of days in the current month.
-        void next( );                // Advances the date by one day.
-        void previous( );            // Backs up the date by one day.
+        constexpr bool is_leap( ) const;       // Return true if the current year is a leap year.
+        constexpr int  month_length( ) const;  // Return the number of days in the current month.
+        constexpr void set_serial( long new_serial );  // Sets all members from a serial number.
+
+        // Checks a date. Set( int, int, int ) throws an exception for each status other than ok.
+        static constexpr Status validate( int year, int month, int day ) noexcept;
+
+        // Returns the serial number of a date that has already been validated.
+        static constexpr int serial_of( int year, int month, int day ) noexcept;
+
+        // Extracts the fields of a string in either format without checking their values.
+        static bool parse_fields( std::string_view date_string, int &year, int &month, int &day ) noexcept;
     };
 
 
@@ -180,19 +270,234 @@ namespace vtsu {
     //! Computes how many days difference there is between two dates.
     /*!
      * The return value is zero if 'future' and 'past' are the same date, positive if 'future'
-     * comes after 'past', and negative otherwise.
+     * comes after 'past', and negative otherwise. This takes constant time.
      * 
      * \todo Is the return type of 'long' the best choice here? Perhaps 'int' would be good
      * enough. How many days are in the range Jan 1, Date::minimum_year to Dec 31,
-     * Date::maximum_year?
+     * Date::maximum_year? (Answer: 91,311.)
+     */
+    constexpr long difference( const Date &future, const Date &past );
+
+    //! Parses many date strings at once.
+    /*!
+     * Each element of `date_strings` is parsed as by Date::set( std::string_view ). The result
+     * is stored in the corresponding element of `dates` if it is valid; otherwise that element
+     * of `dates` is left unchanged. Either way the outcome is stored in the corresponding
+     * element of `statuses`. No exceptions are thrown for invalid strings.
+     *
+     * \return The number of strings that could not be parsed.
+     * \throws std::invalid_argument if `dates` or `statuses` is smaller than `date_strings`.
+     */
+    std::size_t parse_dates( std::span<const std::string_view> date_strings,
+                             std::span<Date> dates,
+                             std::span<Date::Status> statuses );
+
+    //! The number of characters written by to_chars( ) for a Date.
+    constexpr std::size_t date_chars = 10;
+
+    //! Writes a Date in the form yyyy-mm-dd into [first, last).
+    /*!
+     * This is like std::to_chars: it doesn't allocate memory, throw exceptions, or depend on
+     * the locale. No null character is written.
+     *
+     * \return On success, `ptr` points after the last character written and `ec` is zero. If
+     * there are fewer than date_chars characters available, `ptr` is `last` and `ec` is
+     * std::errc::value_too_large.
      */
-    long difference( const Date &future, const Date &past );
+    std::to_chars_result to_chars( char *first, char *last, const Date &the_date ) noexcept;
+
+    //! Appends many Dates to a string.
+    /*!
+     * Each Date is written in the form yyyy-mm-dd and followed by `separator`. The string is
+     * enlarged once, so all the text is written into one contiguous buffer.
+     */
+    void format_dates( std::span<const Date> dates, std::string &text, char separator = '\n' );
 
     //! Writes a Date to an output stream.
     std::ostream &operator<<( std::ostream &output, const Date &the_date );
 
     //! Reads a Date from an input stream.
     std::istream &operator>>( std::istream &input, Date &the_date );
+
+
+    // Calendar Tables
+    // ===============
+
+    // These tables are computed by the compiler. They cover exactly the years a Date allows,
+    // so finding the serial number of a date, or the date of a serial number, takes a few table
+    // lookups instead of the division heavy formulas of days_from_civil( ) and
+    // civil_from_days( ). The tables take about 2 KB.
+
+    namespace calendar {
+
+        //! The number of years in the allowed range.
+        constexpr int year_count = Date::maximum_year - Date::minimum_year + 1;
+
+        //! Element i is the serial number of January 1 of year Date::minimum_year + i.
+        /*!
+         * The last element is the serial number of January 1 of the year after
+         * Date::maximum_year, so the length of year i is year_start[i + 1] - year_start[i].
+         */
+        inline constexpr std::array<int, year_count + 1> year_start = [] {
+            std::array<int, year_count + 1> result{ };
+            for( int i = 0; i <= year_count; ++i ) {
+                result[i] = days_from_civil( Date::minimum_year + i, 1, 1 );
+            }
+            return result;
+        }( );
+
+        //! Element i is true if year Date::minimum_year + i is a leap year.
+        inline constexpr std::array<bool, year_count> leap_year = [] {
+            std::array<bool, year_count> result{ };
+            for( int i = 0; i < year_count; ++i ) {
+                result[i] = ( year_start[i + 1] - year_start[i] == 366 );
+            }
+            return result;
+        }( );
+
+        //! Element [leap][m] is the number of days in the year before month m + 1 (0-based m).
+        /*!
+         * The first index is 1 for leap years and 0 otherwise. Element [leap][12] is the length
+         * of the year, so the length of month m + 1 is month_start[leap][m + 1] -
+         * month_start[leap][m].
+         */
+        inline constexpr std::array<std::array<int, 13>, 2> month_start = [] {
+            std::array<std::array<int, 13>, 2> result{ };
+            for( int leap = 0; leap < 2; ++leap ) {
+                for( int month = 1; month <= 12; ++month ) {
+                    result[leap][month - 1] =
+                        days_from_civil( 1999 + leap, month, 1 ) - days_from_civil( 1999 + leap, 1, 1 );
+                }
+                result[leap][12] = 365 + leap;
+            }
+            return result;
+        }( );
+
+        //! The smallest serial number of a Date (January 1, Date::minimum_year).
+        constexpr int minimum_serial = year_start[0];
+
+        //! The largest serial number of a Date (December 31, Date::maximum_year).
+        constexpr int maximum_serial = year_start[year_count] - 1;
+    }
+
+
+    // Inline Methods
+    // ==============
+
+    // The methods below are constexpr, so they must be defined in the header. Each of them can
+    // throw an exception, which makes a compile time computation that would throw a compile
+    // time error.
+
+    constexpr bool Date::is_leap( ) const
+    {
+        return calendar::leap_year[year - minimum_year];
+    }
+
+
+    constexpr int Date::month_length( ) const
+    {
+        const auto &starts = calendar::month_start[is_leap( )];
+        return starts[month] - starts[month - 1];
+    }
+
+
+    constexpr Date::Status Date::validate( int year, int month, int day ) noexcept
+    {
+        // An out of range year takes precedence over other problems.
+        if( year < minimum_year || year > maximum_year ) return Status::out_of_range;
+        if( month < 1 || month > 12 ) return Status::invalid;
+        const auto &starts = calendar::month_start[calendar::leap_year[year - minimum_year]];
+        if( day < 1 || day > starts[month] - starts[month - 1] ) return Status::invalid;
+        return Status::ok;
+    }
+
+
+    constexpr int Date::serial_of( int year, int month, int day ) noexcept
+    {
+        const int index = year - minimum_year;
+        return calendar::year_start[index] + calendar::month_start[calendar::leap_year[index]][month - 1] + day - 1;
+    }
+
+
+    constexpr void Date::set_serial( long new_serial )
+    {
+        if( new_serial < calendar::minimum_serial || new_serial > calendar::maximum_serial )
+            throw OutOfRange( "Date out of range in Date::set_serial( long )" );
+
+        // Estimate the year using the average length of a year (146,097 days in 400 years). The
+        // estimate is never off by more than one year in the allowed range.
+        const int new_int_serial = static_cast<int>( new_serial );
+        int index = ( 400 * ( new_int_serial - calendar::minimum_serial ) ) / 146097;
+        if( new_int_serial < calendar::year_start[index] ) --index;
+        else if( new_int_serial >= calendar::year_start[index + 1] ) ++index;
+
+        // Every month has between 28 and 31 days, so dividing the day of the year by 32 gives
+        // either the right month or the one before it.
+        const auto &starts = calendar::month_start[calendar::leap_year[index]];
+        const int day_of_year = new_int_serial - calendar::year_start[index];
+        int month_index = day_of_year / 32;
+        if( day_of_year >= starts[month_index + 1] ) ++month_index;
+
+        serial = new_int_serial;
+        year   = minimum_year + index;
+        month  = month_index + 1;
+        day    = day_of_year - starts[month_index] + 1;
+    }
+
+
+    constexpr Date::Date( ) :
+        serial( calendar::minimum_serial ), year( minimum_year ), month( 1 ), day( 1 )
+    { }
+
+
+    constexpr Date::Date( int year, int month, int day ) : serial( 0 ), year( 0 ), month( 0 ), day( 0 )
+    {
+        set( year, month, day );
+    }
+
+
+    constexpr void Date::set( int year, int month, int day )
+    {
+        switch( validate( year, month, day ) ) {
+        case Status::ok:
+            break;
+        case Status::out_of_range:
+            throw OutOfRange( "Date out of range in Date::set( int, int, int )" );
+        case Status::invalid:
+            if( month < 1 || month > 12 )
+                throw Invalid( "Invalid month in Date::set( int, int, int )" );
+            throw Invalid( "Invalid day in Date::set( int, int, int )" );
+        }
+
+        // Install the new date information.
+        this->year = year; this->month = month; this->day = day;
+        serial = serial_of( year, month, day );
+    }
+
+
+    constexpr Date Date::from_serial( long serial )
+    {
+        Date result;
+        result.set_serial( serial );
+        return result;
+    }
+
+
+    constexpr void Date::advance( long delta )
+    {
+        // Check the range before adding so that a huge delta can't overflow. If the new date
+        // is out of range, set_serial( ) throws without changing the Date.
+        if( delta > calendar::maximum_serial - serial || delta < calendar::minimum_serial - serial )
+            throw OutOfRange( "Date out of range in Date::advance( long )" );
+
+        set_serial( serial + delta );
+    }
+
+
+    constexpr long difference( const Date &future, const Date &past )
+    {
+        return static_cast<long>( future.get_serial( ) ) - past.get_serial( );
+    }
 }
 
 #endif
@@ -0,0 +1,169 @@
+/*! \file    DateColumn.cpp
+ *  \brief   Implementation of compact dates and columns of dates.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DateColumn.hpp"
+
+using namespace std;
+
+namespace vtsu {
+
+    namespace {
+
+        // Returns the number of months from January of Date::minimum_year to the month
+        // containing the given serial day number. This is the conversion done by
+        // civil_from_days( ) with the computation of the day left out. It has no branches (the
+        // conditional expressions become conditional moves) and divides only by constants, so
+        // the loops that use it can be vectorized. All dates in the allowed range have
+        // non-negative era numbers, so the era computation is also simpler.
+        inline int month_index( int serial )
+        {
+            serial += 719468;
+            const int era = serial / 146097;
+            const int day_of_era  = serial - era * 146097;
+            const int year_of_era =
+                ( day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096 ) / 365;
+            const int day_of_year = day_of_era - ( 365 * year_of_era + year_of_era / 4 - year_of_era / 100 );
+            const int shifted_month = ( 5 * day_of_year + 2 ) / 153;
+            // The shifted year starts in March, so January and February belong to the next year.
+            return 12 * ( year_of_era + era * 400 - Date::minimum_year ) + shifted_month + 2;
+        }
+
+    }
+
+
+    ostream &operator<<( ostream &output, PackedDate the_date )
+    {
+        return output << the_date.to_date( );
+    }
+
+
+    istream &operator>>( istream &input, PackedDate &the_date )
+    {
+        Date unpacked;
+        if( input >> unpacked ) the_date = unpacked;
+        return input;
+    }
+
+
+    PackedDate DateColumn::operator[]( size_t index ) const
+    {
+        return Date::from_serial( serials[index] );
+    }
+
+
+    size_t DateColumn::count_between( PackedDate first, PackedDate last ) const
+    {
+        // Subtracting `first` and comparing as unsigned values checks both ends of the range
+        // with one comparison. If first > last the range is empty.
+        if( last < first ) return 0;
+        const uint32_t low   = static_cast<uint32_t>( first.get_serial( ) );
+        const uint32_t width = static_cast<uint32_t>( last.get_serial( ) ) - low;
+        size_t count = 0;
+        for( int32_t serial : serials ) {
+            count += ( static_cast<uint32_t>( serial ) - low <= width );
+        }
+        return count;
+    }
+
+
+    vector<size_t> DateColumn::select_between( PackedDate first, PackedDate last ) const
+    {
+        vector<size_t> result;
+        if( last < first ) return result;
+        const uint32_t low   = static_cast<uint32_t>( first.get_serial( ) );
+        const uint32_t width = static_cast<uint32_t>( last.get_serial( ) ) - low;
+
+        // Every index is written, but the position only advances past the indices that are
+        // selected. This avoids a branch that would be mispredicted often for unsorted data.
+        result.resize( serials.size( ) );
+        size_t selected = 0;
+        for( size_t i = 0; i < serials.size( ); ++i ) {
+            result[selected] = i;
+            selected += ( static_cast<uint32_t>( serials[i] ) - low <= width );
+        }
+        result.resize( selected );
+        return result;
+    }
+
+
+    void DateColumn::bucket_by_year( vector<uint16_t> &buckets ) const
+    {
+        buckets.resize( serials.size( ) );
+        for( size_t i = 0; i < serials.size( ); ++i ) {
+            buckets[i] = static_cast<uint16_t>( month_index( serials[i] ) / 12 );
+        }
+    }
+
+
+    void DateColumn::bucket_by_month( vector<uint16_t> &buckets ) const
+    {
+        buckets.resize( serials.size( ) );
+        for( size_t i = 0; i < serials.size( ); ++i ) {
+            buckets[i] = static_cast<uint16_t>( month_index( serials[i] ) );
+        }
+    }
+
+
+    vector<size_t> DateColumn::count_by_year( ) const
+    {
+        vector<size_t> counts( year_count );
+        for( int32_t serial : serials ) {
+            ++counts[month_index( serial ) / 12];
+        }
+        return counts;
+    }
+
+
+    vector<size_t> DateColumn::count_by_month( ) const
+    {
+        vector<size_t> counts( month_count );
+        for( int32_t serial : serials ) {
+            ++counts[month_index( serial )];
+        }
+        return counts;
+    }
+
+
+    void DateColumn::days_since( PackedDate origin, vector<int32_t> &result ) const
+    {
+        const int32_t base = origin.get_serial( );
+        result.resize( serials.size( ) );
+        for( size_t i = 0; i < serials.size( ); ++i ) {
+            result[i] = serials[i] - base;
+        }
+    }
+
+
+    void DateColumn::difference( const DateColumn &past, vector<int32_t> &result ) const
+    {
+        if( past.size( ) != size( ) )
+            throw invalid_argument( "DateColumn::difference: columns have different sizes" );
+
+        result.resize( serials.size( ) );
+        for( size_t i = 0; i < serials.size( ); ++i ) {
+            result[i] = serials[i] - past.serials[i];
+        }
+    }
+
+
+    void format_dates( const DateColumn &column, string &text, char separator )
+    {
+        const size_t original_size = text.size( );
+        text.resize( original_size + column.size( ) * ( date_chars + 1 ) );
+        char *p = text.data( ) + original_size;
+        for( int32_t serial : span( column.data( ), column.size( ) ) ) {
+            p = to_chars( p, p + date_chars, Date::from_serial( serial ) ).ptr;
+            *p++ = separator;
+        }
+    }
+
+}
@@ -0,0 +1,146 @@
+/*! \file    DateColumn.hpp
+ *  \brief   Interface to compact dates and columns of dates.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * A Date holds both a serial day number and the year, month, and day, which is convenient but
+ * takes 16 bytes. Programs that keep very large numbers of dates in memory can use PackedDate
+ * instead. It holds only the serial day number, in four bytes. (The 91,311 days in the allowed
+ * range of dates don't quite fit in 16 bits.) A DateColumn is a sequence of packed dates with
+ * operations on the whole column that are written as simple loops the compiler can vectorize.
+ */
+
+#ifndef DATECOLUMN_HPP
+#define DATECOLUMN_HPP
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "Date3.hpp"
+
+namespace vtsu {
+
+    //! A Date stored in four bytes.
+    /*!
+     * PackedDates are converted to and from Dates for access to the year, month, and day and
+     * for I/O. They can be compared and subtracted directly.
+     */
+    class PackedDate {
+    public:
+        //! Initializes the PackedDate to January 1, Date::minimum_year (as for Date).
+        constexpr PackedDate( ) : serial( Date( ).get_serial( ) ) { }
+
+        //! Packs a Date. This is an implicit conversion.
+        constexpr PackedDate( const Date &date ) : serial( date.get_serial( ) ) { }
+
+        //! Unpacks this PackedDate.
+        constexpr Date to_date( ) const
+            { return Date::from_serial( serial ); }
+
+        constexpr int get_year( ) const
+            { return to_date( ).get_year( ); }
+
+        constexpr int get_month( ) const
+            { return to_date( ).get_month( ); }
+
+        constexpr int get_day( ) const
+            { return to_date( ).get_day( ); }
+
+        //! Returns the number of days from January 1, 1970 to this date (see Date::get_serial).
+        constexpr std::int32_t get_serial( ) const
+            { return serial; }
+
+        auto operator<=>( const PackedDate &other ) const = default;
+
+    private:
+        std::int32_t serial;
+    };
+
+    //! Returns the number of days from `past` to `future` (see difference( Date, Date )).
+    constexpr long difference( PackedDate future, PackedDate past )
+    {
+        return static_cast<long>( future.get_serial( ) ) - past.get_serial( );
+    }
+
+    //! Writes a PackedDate to an output stream in the same way as a Date.
+    std::ostream &operator<<( std::ostream &output, PackedDate the_date );
+
+    //! Reads a PackedDate from an input stream in the same way as a Date.
+    std::istream &operator>>( std::istream &input, PackedDate &the_date );
+
+
+    //! A sequence of dates stored compactly.
+    /*!
+     * The column stores the serial day numbers of its dates in a single contiguous array. The
+     * operations on whole columns below avoid converting each element to a Date.
+     */
+    class DateColumn {
+    public:
+        //! The number of years (and buckets for bucket_by_year) in the allowed range of dates.
+        static const int year_count = Date::maximum_year - Date::minimum_year + 1;
+
+        //! The number of months (and buckets for bucket_by_month) in the allowed range.
+        static const int month_count = 12 * year_count;
+
+        DateColumn( ) = default;
+
+        std::size_t size( ) const
+            { return serials.size( ); }
+
+        bool empty( ) const
+            { return serials.empty( ); }
+
+        void reserve( std::size_t count )
+            { serials.reserve( count ); }
+
+        void push_back( PackedDate date )
+            { serials.push_back( date.get_serial( ) ); }
+
+        //! Returns element `index`. There is no bounds checking.
+        PackedDate operator[]( std::size_t index ) const;
+
+        //! The serial day numbers of the dates in the column.
+        const std::int32_t *data( ) const
+            { return serials.data( ); }
+
+        //! Returns the number of dates d with first <= d <= last.
+        std::size_t count_between( PackedDate first, PackedDate last ) const;
+
+        //! Returns the indices of the dates d with first <= d <= last, in increasing order.
+        std::vector<std::size_t> select_between( PackedDate first, PackedDate last ) const;
+
+        //! Stores the year of each date as a bucket number, counting Date::minimum_year as 0.
+        void bucket_by_year( std::vector<std::uint16_t> &buckets ) const;
+
+        //! Stores the month of each date as a bucket number, counting from 0 for January of
+        //! Date::minimum_year. Every month in the allowed range has its own bucket.
+        void bucket_by_month( std::vector<std::uint16_t> &buckets ) const;
+
+        //! Returns the number of dates in each year, indexed as for bucket_by_year.
+        std::vector<std::size_t> count_by_year( ) const;
+
+        //! Returns the number of dates in each month, indexed as for bucket_by_month.
+        std::vector<std::size_t> count_by_month( ) const;
+
+        //! Stores the number of days from `origin` to each date (negative for earlier dates).
+        void days_since( PackedDate origin, std::vector<std::int32_t> &result ) const;
+
+        //! Stores the number of days from each date in `past` to the corresponding date here.
+        /*!
+         * \throws std::invalid_argument if the columns have different sizes.
+         */
+        void difference( const DateColumn &past, std::vector<std::int32_t> &result ) const;
+
+    private:
+        std::vector<std::int32_t> serials;
+    };
+
+    //! Appends the dates in a column to a string (see format_dates( std::span<const Date>, ... )).
+    void format_dates( const DateColumn &column, std::string &text, char separator = '\n' );
+
+}
+
+#endif
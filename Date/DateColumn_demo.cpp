@@ -0,0 +1,80 @@
+/*! \file    DateColumn_demo.cpp
+ *  \brief   A program that demonstrates PackedDate and DateColumn.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * This program fills a DateColumn with random dates, counts and selects the dates in a range,
+ * and counts the dates in each year. Each result is checked against the same computation done
+ * with ordinary Dates. The number of dates can be given on the command line.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "Date3.hpp"
+#include "DateColumn.hpp"
+
+using namespace std;
+
+int main( int argc, char **argv )
+{
+    size_t count = 100'000;
+    if( argc > 1 ) count = static_cast<size_t>( atol( argv[1] ) );
+
+    cout << "sizeof( Date ) = " << sizeof( vtsu::Date )
+         << ", sizeof( PackedDate ) = " << sizeof( vtsu::PackedDate ) << "\n";
+
+    mt19937 generator( 42 );
+    uniform_int_distribution<long> offset( 0, 91'310 );
+    vector<vtsu::Date> dates;
+    vtsu::DateColumn column;
+    dates.reserve( count );
+    column.reserve( count );
+    for( size_t i = 0; i < count; ++i ) {
+        vtsu::Date date;
+        date.advance( offset( generator ) );
+        dates.push_back( date );
+        column.push_back( date );
+    }
+
+    const vtsu::Date first{ 2000, 2, 29 };
+    const vtsu::Date last { 2024, 12, 31 };
+    const vector<size_t> selected = column.select_between( first, last );
+    const vector<size_t> by_year  = column.count_by_year( );
+    vector<uint16_t> months;
+    column.bucket_by_month( months );
+
+    // Check the column operations against the same computations done with Dates.
+    size_t expected = 0;
+    vector<size_t> expected_by_year( vtsu::DateColumn::year_count );
+    for( size_t i = 0; i < count; ++i ) {
+        const vtsu::Date &date = dates[i];
+        if( first <= date && date <= last ) {
+            if( expected >= selected.size( ) || selected[expected] != i ) {
+                cout << "select_between failed at element " << i << "\n";
+                return EXIT_FAILURE;
+            }
+            ++expected;
+        }
+        ++expected_by_year[date.get_year( ) - vtsu::Date::minimum_year];
+        const int month = 12 * ( date.get_year( ) - vtsu::Date::minimum_year ) + date.get_month( ) - 1;
+        if( months[i] != month || column[i].to_date( ) != date ) {
+            cout << "Element " << i << " (" << date << ") doesn't match\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if( expected != selected.size( ) || expected != column.count_between( first, last ) ||
+        expected_by_year != by_year ) {
+        cout << "Counts don't match\n";
+        return EXIT_FAILURE;
+    }
+
+    cout << expected << " of " << count << " dates are between " << first << " and " << last << "\n";
+    for( int year = 2020; year <= 2024; ++year ) {
+        cout << "  " << year << ": " << by_year[year - vtsu::Date::minimum_year] << "\n";
+    }
+    vector<int32_t> ages;
+    column.days_since( last, ages );
+    cout << "The first date, " << column[0] << ", is " << ages[0] << " days from " << last << "\n";
+    return EXIT_SUCCESS;
+}
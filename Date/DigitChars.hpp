@@ -0,0 +1,53 @@
+/*! \file    DigitChars.hpp
+ *  \brief   Internal helpers for reading and writing fixed width decimal fields.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * These are shared by the character conversions of Date, Time, and DateTime. They aren't part
+ * of the interface of any of those classes.
+ */
+
+#ifndef DIGITCHARS_HPP
+#define DIGITCHARS_HPP
+
+namespace vtsu {
+
+    namespace digits {
+
+        //! The decimal representation of each number from 0 to 99, as two characters.
+        /*!
+         * Looking up both digits at once halves the number of divisions needed to format a
+         * number.
+         */
+        inline constexpr char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        //! Writes the two decimal digits of `value` (0 .. 99) to text[0] and text[1].
+        inline void write_pair( char *text, unsigned value ) noexcept
+        {
+            text[0] = pairs[2 * value];
+            text[1] = pairs[2 * value + 1];
+        }
+
+        //! Converts exactly `count` decimal digits starting at `text` into an integer.
+        /*!
+         * Only the ASCII digits are accepted. If any of the characters isn't a digit, returns
+         * false and leaves `value` unchanged.
+         */
+        inline bool parse_fixed( const char *text, int count, int &value ) noexcept
+        {
+            int result = 0;
+            for( int i = 0; i < count; ++i ) {
+                const unsigned digit = static_cast<unsigned char>( text[i] ) - '0';
+                if( digit > 9 ) return false;
+                result = 10 * result + static_cast<int>( digit );
+            }
+            value = result;
+            return true;
+        }
+
+    }
+}
+
+#endif
@@ -0,0 +1,310 @@
+/*! \file    DateTime.cpp
+ *  \brief   Implementation of combined dates and times.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ */
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DateTime.hpp"
+#include "../Date/DigitChars.hpp"
+
+using namespace std;
+
+namespace vtsu {
+
+    namespace {
+
+        constexpr int64_t minimum_count = calendar::minimum_serial * DateTime::nanoseconds_per_day;
+        constexpr int64_t maximum_count = ( calendar::maximum_serial + 1LL ) * DateTime::nanoseconds_per_day - 1;
+
+        // Division that rounds toward negative infinity (the built in division rounds toward
+        // zero). The divisor must be positive. This is needed for DateTimes before 1970.
+        inline int64_t floor_divide( int64_t dividend, int64_t divisor )
+        {
+            const int64_t quotient = dividend / divisor;
+            return quotient - ( dividend % divisor < 0 );
+        }
+
+        // Builds a DateTime from a count that is known to be in range.
+        DateTime from_count( int64_t count )
+        {
+            return DateTime( DateTime::sys_time( DateTime::duration( count ) ) );
+        }
+    }
+
+
+    // Public Methods
+    // ==============
+
+    DateTime::DateTime( ) : count( minimum_count )
+    { }
+
+
+    DateTime::DateTime( const Date &date, const Time &time, long nanoseconds )
+    {
+        if( nanoseconds < 0 || nanoseconds >= nanoseconds_per_second )
+            throw invalid_argument( "Invalid nanoseconds in DateTime::DateTime( const Date &, const Time &, long )" );
+
+        count = date.get_serial( ) * nanoseconds_per_day +
+                time.get_seconds_of_day( ) * nanoseconds_per_second + nanoseconds;
+    }
+
+
+    DateTime::DateTime( sys_time time_point )
+    {
+        const int64_t incoming_count = time_point.time_since_epoch( ).count( );
+        if( incoming_count < minimum_count || incoming_count > maximum_count )
+            throw Date::OutOfRange( "DateTime out of range in DateTime::DateTime( sys_time )" );
+
+        count = incoming_count;
+    }
+
+
+    DateTime::DateTime( string_view date_time_string ) : count( minimum_count )
+    {
+        const char *const end = date_time_string.data( ) + date_time_string.size( );
+        auto [ptr, ec] = from_chars( date_time_string.data( ), end, *this );
+        if( ec == errc::result_out_of_range )
+            throw Date::OutOfRange( "Date out of range in DateTime::DateTime( std::string_view )" );
+        if( ec != errc{ } || ptr != end )
+            throw Date::Invalid( "Invalid date and time string in DateTime::DateTime( std::string_view )" );
+    }
+
+
+    Date DateTime::get_date( ) const
+    {
+        return Date::from_serial( floor_divide( count, nanoseconds_per_day ) );
+    }
+
+
+    Time DateTime::get_time( ) const
+    {
+        const int64_t day_start = floor_divide( count, nanoseconds_per_day ) * nanoseconds_per_day;
+        return Time( 0U, 0U, static_cast<unsigned>( ( count - day_start ) / nanoseconds_per_second ) );
+    }
+
+
+    long DateTime::get_nanoseconds( ) const
+    {
+        return static_cast<long>( count - floor_divide( count, nanoseconds_per_second ) * nanoseconds_per_second );
+    }
+
+
+    void DateTime::advance( duration delta )
+    {
+        // Check the range before adding so that a huge delta can't overflow.
+        const int64_t nanoseconds = delta.count( );
+        if( nanoseconds > maximum_count - count || nanoseconds < minimum_count - count )
+            throw Date::OutOfRange( "DateTime out of range in DateTime::advance( duration )" );
+
+        count += nanoseconds;
+    }
+
+
+    // Free Functions
+    // ==============
+
+    to_chars_result to_chars( char *first, char *last, const DateTime &date_time, int fraction_digits ) noexcept
+    {
+        if( fraction_digits < 0 ) fraction_digits = 0;
+        if( fraction_digits > 9 ) fraction_digits = 9;
+        const size_t length = date_chars + 1 + time_chars + ( fraction_digits > 0 ? fraction_digits + 1 : 0 ) + 1;
+        if( last - first < static_cast<ptrdiff_t>( length ) ) return { last, errc::value_too_large };
+
+        char *p = to_chars( first, last, date_time.get_date( ) ).ptr;
+        *p++ = 'T';
+        p = to_chars( p, last, date_time.get_time( ) ).ptr;
+        if( fraction_digits > 0 ) {
+            // Write all nine digits from right to left, then keep only the ones asked for.
+            char digits[9];
+            long nanoseconds = date_time.get_nanoseconds( );
+            for( int i = 8; i >= 0; --i ) {
+                digits[i] = static_cast<char>( '0' + nanoseconds % 10 );
+                nanoseconds /= 10;
+            }
+            *p++ = '.';
+            for( int i = 0; i < fraction_digits; ++i ) *p++ = digits[i];
+        }
+        *p++ = 'Z';
+        return { p, errc{ } };
+    }
+
+
+    // The date is checked by Date::try_set( ), which also accepts the mm/dd/yyyy format, so the
+    // dashes are checked here first. The time must have exactly two digits in each field and
+    // doesn't wrap around (unlike the strings accepted by Time).
+    from_chars_result from_chars( const char *first, const char *last, DateTime &date_time ) noexcept
+    {
+        const from_chars_result invalid{ first, errc::invalid_argument };
+        if( last - first < 19 || first[4] != '-' || first[7] != '-' ) return invalid;
+        if( first[10] != 'T' && first[10] != 't' && first[10] != ' ' ) return invalid;
+        if( first[13] != ':' || first[16] != ':' ) return invalid;
+
+        Date date;
+        switch( date.try_set( string_view( first, date_chars ) ) ) {
+        case Date::Status::ok:
+            break;
+        case Date::Status::out_of_range:
+            return { first, errc::result_out_of_range };
+        case Date::Status::invalid:
+            return invalid;
+        }
+
+        int hours;
+        int minutes;
+        int seconds;
+        if( !digits::parse_fixed( first + 11, 2, hours ) || !digits::parse_fixed( first + 14, 2, minutes ) ||
+            !digits::parse_fixed( first + 17, 2, seconds ) ) return invalid;
+        if( hours > 23 || minutes > 59 || seconds > 59 ) return invalid;
+
+        // The fraction of a second is optional. Digits after the ninth are ignored.
+        const char *p = first + 19;
+        int64_t nanoseconds = 0;
+        if( p != last && *p == '.' ) {
+            const char *digits = ++p;
+            int64_t scale = DateTime::nanoseconds_per_second;
+            for( ; p != last; ++p ) {
+                const unsigned digit = static_cast<unsigned char>( *p ) - '0';
+                if( digit > 9 ) break;
+                if( scale > 1 ) {
+                    scale /= 10;
+                    nanoseconds += digit * scale;
+                }
+            }
+            if( p == digits ) return invalid;
+        }
+        if( p != last && ( *p == 'Z' || *p == 'z' ) ) ++p;
+
+        date_time = DateTime( date, Time( hours, minutes, seconds ), static_cast<long>( nanoseconds ) );
+        return { p, errc{ } };
+    }
+
+
+    size_t parse_date_times( span<const string_view> strings, span<DateTime> date_times, span<Date::Status> statuses )
+    {
+        if( date_times.size( ) < strings.size( ) || statuses.size( ) < strings.size( ) )
+            throw invalid_argument( "Output spans too small in parse_date_times( )" );
+
+        size_t failures = 0;
+        for( size_t i = 0; i < strings.size( ); ++i ) {
+            const char *const end = strings[i].data( ) + strings[i].size( );
+            auto [ptr, ec] = from_chars( strings[i].data( ), end, date_times[i] );
+            if( ec == errc{ } && ptr == end ) {
+                statuses[i] = Date::Status::ok;
+            }
+            else {
+                statuses[i] = ( ec == errc::result_out_of_range ) ? Date::Status::out_of_range : Date::Status::invalid;
+                ++failures;
+            }
+        }
+        return failures;
+    }
+
+
+    void format_date_times( span<const DateTime> date_times, string &text, int fraction_digits, char separator )
+    {
+        // Every DateTime is written with the same length, so the string is enlarged for all of
+        // them at once and then trimmed to the space actually used.
+        const size_t original_size = text.size( );
+        text.resize( original_size + date_times.size( ) * ( date_time_chars + 1 ) );
+        char *p = text.data( ) + original_size;
+        char *const end = text.data( ) + text.size( );
+        for( const DateTime &date_time : date_times ) {
+            p = to_chars( p, end, date_time, fraction_digits ).ptr;
+            *p++ = separator;
+        }
+        text.resize( static_cast<size_t>( p - text.data( ) ) );
+    }
+
+
+    // The output is formatted with to_chars and then written as a single string, so the
+    // stream's field width and fill character apply to the whole value.
+    ostream &operator<<( ostream &output, const DateTime &date_time )
+    {
+        char buffer[date_time_chars];
+        auto result = to_chars( buffer, buffer + sizeof( buffer ), date_time, date_time.get_nanoseconds( ) != 0 ? 9 : 0 );
+        return output << string_view( buffer, static_cast<size_t>( result.ptr - buffer ) );
+    }
+
+
+    istream &operator>>( istream &input, DateTime &date_time )
+    {
+        string date_time_string;
+
+        // If the constructor throws an exception, 'date_time' will not be changed.
+        if( input >> date_time_string ) date_time = DateTime( date_time_string );
+        return input;
+    }
+
+
+    // TimestampColumn
+    // ===============
+
+    DateTime TimestampColumn::operator[]( size_t index ) const
+    {
+        return from_count( counts[index] );
+    }
+
+
+    size_t TimestampColumn::count_between( const DateTime &first, const DateTime &last ) const
+    {
+        // Subtracting `first` and comparing as unsigned values checks both ends of the range
+        // with one comparison (see DateColumn::count_between( )).
+        if( last < first ) return 0;
+        const uint64_t low   = static_cast<uint64_t>( first.get_count( ) );
+        const uint64_t width = static_cast<uint64_t>( last.get_count( ) ) - low;
+        size_t count = 0;
+        for( int64_t value : counts ) {
+            count += ( static_cast<uint64_t>( value ) - low <= width );
+        }
+        return count;
+    }
+
+
+    void TimestampColumn::bucket( const DateTime &origin, DateTime::duration width, vector<int64_t> &buckets ) const
+    {
+        if( width.count( ) <= 0 )
+            throw invalid_argument( "Bucket width must be positive in TimestampColumn::bucket( )" );
+
+        // All counts are in range, so their differences from `origin` can't overflow.
+        const int64_t base = origin.get_count( );
+        const int64_t divisor = width.count( );
+        buckets.resize( counts.size( ) );
+        for( size_t i = 0; i < counts.size( ); ++i ) {
+            buckets[i] = floor_divide( counts[i] - base, divisor );
+        }
+    }
+
+
+    vector<size_t> TimestampColumn::count_by_bucket( const DateTime &origin,
+                                                     DateTime::duration width,
+                                                     size_t bucket_count ) const
+    {
+        vector<int64_t> buckets;
+        bucket( origin, width, buckets );
+        vector<size_t> result( bucket_count );
+        for( int64_t index : buckets ) {
+            if( static_cast<uint64_t>( index ) < bucket_count ) ++result[static_cast<size_t>( index )];
+        }
+        return result;
+    }
+
+
+    void TimestampColumn::bucket_by_day( vector<int32_t> &serials ) const
+    {
+        serials.resize( counts.size( ) );
+        for( size_t i = 0; i < counts.size( ); ++i ) {
+            serials[i] = static_cast<int32_t>( floor_divide( counts[i], DateTime::nanoseconds_per_day ) );
+        }
+    }
+
+}
@@ -0,0 +1,244 @@
+/*! \file    DateTime.hpp
+ *  \brief   Interface to combined dates and times.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * A DateTime is a point in time, such as the time stamp on a log record. It combines a
+ * vtsu::Date and a vtsu::Time (plus fractions of a second), but it is stored as a single 64 bit
+ * count of nanoseconds since 1970-01-01 00:00:00 UTC. This is the representation used by
+ * std::chrono::sys_time<std::chrono::nanoseconds>, so converting to and from the standard
+ * library's time points is trivial. The Date and the Time are only computed when asked for.
+ *
+ * DateTimes cover the same range of dates as Date (the years Date::minimum_year through
+ * Date::maximum_year). Unlike Time, DateTime does not wrap around; an attempt to create a
+ * DateTime outside that range throws Date::OutOfRange.
+ */
+
+#ifndef DATETIME_HPP
+#define DATETIME_HPP
+
+#include <charconv>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../Date/Date3.hpp"
+#include "../Time/Time.hpp"
+
+namespace vtsu {
+
+    //! Class representing a date and a time of day, with nanosecond resolution.
+    /*!
+     * All DateTimes are in UTC. On output they are written in the ISO-8601 format
+     * yyyy-mm-ddThh:mm:ss[.fffffffff]Z. On input the same format is accepted, except that the
+     * 'T' may be a space, the fraction may have any number of digits (digits past the ninth
+     * are ignored), and the 'Z' is optional.
+     */
+    class DateTime {
+    public:
+        using duration  = std::chrono::nanoseconds;
+        using sys_time  = std::chrono::sys_time<duration>;
+
+        //! The number of nanoseconds in a second.
+        static const std::int64_t nanoseconds_per_second = 1'000'000'000;
+
+        //! The number of nanoseconds in a day.
+        static const std::int64_t nanoseconds_per_day = 86'400 * nanoseconds_per_second;
+
+        //! Default constructor.
+        /*!
+         * This constructor initializes the DateTime to midnight at the start of the minimum
+         * Date (see Date::Date( )).
+         */
+        DateTime( );
+
+        //! Initialize from a Date, a Time, and a number of nanoseconds after the Time.
+        /*!
+         * \throws std::invalid_argument if nanoseconds isn't in the range 0 .. 999,999,999.
+         */
+        DateTime( const Date &date, const Time &time, long nanoseconds = 0 );
+
+        //! Initialize from a standard library time point. This takes constant time.
+        /*!
+         * Time points with a coarser resolution, such as std::chrono::sys_seconds, are
+         * converted automatically.
+         *
+         * \throws Date::OutOfRange if the time point is outside the allowed range of dates.
+         */
+        explicit DateTime( sys_time time_point );
+
+        //! Initialize using an ISO-8601 string (see from_chars( )).
+        /*!
+         * The entire string must be a date and time.
+         *
+         * \throws Date::OutOfRange if the year is outside the allowed range.
+         * \throws Date::Invalid if the string can't be parsed or has an invalid date or time.
+         */
+        explicit DateTime( std::string_view date_time_string );
+
+        //! Returns the Date part of this DateTime.
+        Date get_date( ) const;
+
+        //! Returns the Time part of this DateTime.
+        Time get_time( ) const;
+
+        //! Returns the nanoseconds after the Time part (in the range 0 .. 999,999,999).
+        long get_nanoseconds( ) const;
+
+        //! Returns the number of nanoseconds since 1970-01-01 00:00:00 (negative before that).
+        std::int64_t get_count( ) const
+            { return count; }
+
+        //! Converts this DateTime to a standard library time point. This takes constant time.
+        sys_time to_sys_time( ) const
+            { return sys_time( duration( count ) ); }
+
+        //! Advance the DateTime by the given amount of time (which can be negative).
+        /*!
+         * \throws Date::OutOfRange if this would give a DateTime outside the allowed range. In
+         * that case the DateTime is left unchanged.
+         */
+        void advance( duration delta );
+
+        auto operator<=>( const DateTime &other ) const = default;
+
+    private:
+        std::int64_t count;  // Nanoseconds since 1970-01-01 00:00:00 UTC.
+    };
+
+
+    // Free Functions
+    // ==============
+
+    //! Returns the amount of time from `past` to `future` (negative if `future` is earlier).
+    inline DateTime::duration difference( const DateTime &future, const DateTime &past )
+    {
+        return DateTime::duration( future.get_count( ) - past.get_count( ) );
+    }
+
+    //! The largest number of characters written by to_chars( ) for a DateTime.
+    constexpr std::size_t date_time_chars = 30;
+
+    //! Writes a DateTime in the form yyyy-mm-ddThh:mm:ss[.fffffffff]Z into [first, last).
+    /*!
+     * The fraction of a second is written with `fraction_digits` digits (0 through 9, with no
+     * decimal point if 0). It is truncated, not rounded. This is like std::to_chars: it doesn't
+     * allocate memory, throw exceptions, or depend on the locale. No null character is written.
+     *
+     * \return On success, `ptr` points after the last character written and `ec` is zero. If
+     * there isn't enough space, `ptr` is `last` and `ec` is std::errc::value_too_large.
+     */
+    std::to_chars_result to_chars( char *first, char *last, const DateTime &date_time, int fraction_digits = 0 ) noexcept;
+
+    //! Parses an ISO-8601 date and time (see DateTime) from the start of [first, last).
+    /*!
+     * \return On success, `ptr` points at the first character after the date and time and `ec`
+     * is zero. If there is no valid date and time at `first`, `ptr` is `first` and `ec` is
+     * std::errc::invalid_argument. If the year is outside the allowed range, `ptr` is `first`
+     * and `ec` is std::errc::result_out_of_range. In both error cases `date_time` is not
+     * changed.
+     */
+    std::from_chars_result from_chars( const char *first, const char *last, DateTime &date_time ) noexcept;
+
+    //! Parses many ISO-8601 strings at once.
+    /*!
+     * This works like parse_dates( ) for Dates. Each string must be exactly one date and time.
+     *
+     * \return The number of strings that could not be parsed.
+     * \throws std::invalid_argument if `date_times` or `statuses` is smaller than `strings`.
+     */
+    std::size_t parse_date_times( std::span<const std::string_view> strings,
+                                  std::span<DateTime> date_times,
+                                  std::span<Date::Status> statuses );
+
+    //! Appends many DateTimes to a string.
+    /*!
+     * Each DateTime is written as by to_chars( ) and followed by `separator`. The string is
+     * enlarged once, so all the text is written into one contiguous buffer.
+     */
+    void format_date_times( std::span<const DateTime> date_times,
+                            std::string &text,
+                            int fraction_digits = 0,
+                            char separator = '\n' );
+
+    //! Writes a DateTime to an output stream.
+    /*!
+     * The fraction of a second is written (with nine digits) only if it isn't zero.
+     */
+    std::ostream &operator<<( std::ostream &output, const DateTime &date_time );
+
+    //! Reads a DateTime from an input stream.
+    /*!
+     * A single word is read, so the date and the time must be separated with a 'T'.
+     *
+     * \throws Date::OutOfRange or Date::Invalid as for DateTime( std::string_view ).
+     */
+    std::istream &operator>>( std::istream &input, DateTime &date_time );
+
+
+    //! A sequence of time stamps stored compactly.
+    /*!
+     * The column stores the nanosecond counts of its DateTimes in a single contiguous array.
+     * The operations on whole columns below are simple branch free loops over that array, so
+     * the compiler can vectorize them where the hardware allows.
+     */
+    class TimestampColumn {
+    public:
+        TimestampColumn( ) = default;
+
+        std::size_t size( ) const
+            { return counts.size( ); }
+
+        bool empty( ) const
+            { return counts.empty( ); }
+
+        void reserve( std::size_t count )
+            { counts.reserve( count ); }
+
+        void push_back( const DateTime &date_time )
+            { counts.push_back( date_time.get_count( ) ); }
+
+        //! Returns element `index`. There is no bounds checking.
+        DateTime operator[]( std::size_t index ) const;
+
+        //! The nanosecond counts of the time stamps in the column (see DateTime::get_count( )).
+        const std::int64_t *data( ) const
+            { return counts.data( ); }
+
+        //! Returns the number of time stamps t with first <= t <= last.
+        std::size_t count_between( const DateTime &first, const DateTime &last ) const;
+
+        //! Stores the bucket number of each time stamp.
+        /*!
+         * Bucket 0 starts at `origin` and each bucket is `width` long. Time stamps before
+         * `origin` have negative bucket numbers.
+         *
+         * \throws std::invalid_argument if `width` isn't positive.
+         */
+        void bucket( const DateTime &origin, DateTime::duration width, std::vector<std::int64_t> &buckets ) const;
+
+        //! Returns the number of time stamps in each of `bucket_count` buckets (see bucket( )).
+        /*!
+         * Time stamps outside of the buckets aren't counted.
+         *
+         * \throws std::invalid_argument if `width` isn't positive.
+         */
+        std::vector<std::size_t> count_by_bucket( const DateTime &origin,
+                                                  DateTime::duration width,
+                                                  std::size_t bucket_count ) const;
+
+        //! Stores the serial number of the Date of each time stamp (see Date::get_serial( )).
+        void bucket_by_day( std::vector<std::int32_t> &serials ) const;
+
+    private:
+        std::vector<std::int64_t> counts;
+    };
+
+}
+
+#endif
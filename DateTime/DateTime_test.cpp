@@ -0,0 +1,324 @@
+/*! \file    DateTime_test.cpp
+ *  \brief   Test program for vtsu::DateTime.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "DateTime.hpp"
+
+using namespace std;
+// using namespace vtsu;
+
+// Helper function to generate a message string that includes the file name and line number.
+string message_helper( const string &message, const string &file, int line )
+{
+    return message + " (" + file + ":" + to_string( line ) + ")";
+}
+
+
+// Returns the DateTime as a string with all nine fraction digits.
+string full_string( const vtsu::DateTime &date_time )
+{
+    char buffer[vtsu::date_time_chars];
+    auto result = vtsu::to_chars( buffer, buffer + sizeof( buffer ), date_time, 9 );
+    return string( buffer, result.ptr );
+}
+
+
+// Constructor, accessor, and conversion tests.
+void test1( )
+{
+    std::cout << "Constructor DateTime( ) ... ";
+    vtsu::DateTime t1;
+    if( t1.get_date( ) != vtsu::Date( ) || t1.get_time( ) != vtsu::Time( ) || t1.get_nanoseconds( ) != 0 ) {
+        throw runtime_error( message_helper( "Default constructor failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "Constructor DateTime( const Date &, const Time &, long ) ... ";
+    vtsu::DateTime t2{ vtsu::Date( 1969, 12, 31 ), vtsu::Time( 23U, 59U, 59U ), 500'000'000 };
+    if( t2.get_count( ) != -500'000'000 || t2.get_date( ) != vtsu::Date( 1969, 12, 31 ) ||
+        t2.get_time( ) != vtsu::Time( 23U, 59U, 59U ) || t2.get_nanoseconds( ) != 500'000'000 ) {
+        throw runtime_error( message_helper( "Constructor failed", __FILE__, __LINE__ ) );
+    }
+    bool caught = false;
+    try {
+        vtsu::DateTime t3{ vtsu::Date( ), vtsu::Time( ), 1'000'000'000 };
+    }
+    catch( const invalid_argument & ) {
+        caught = true;
+    }
+    if( !caught ) {
+        throw runtime_error( message_helper( "Constructor accepted invalid nanoseconds", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+
+    // Compare with the calendar computations of the standard library for random time points
+    // throughout the allowed range.
+    std::cout << "Conversions to and from sys_time ... ";
+    using namespace std::chrono;
+    const sys_seconds first = sys_days( year( vtsu::Date::minimum_year ) / January / 1 );
+    const sys_seconds last  = sys_days( year( vtsu::Date::maximum_year ) / December / 31 ) + seconds( 86'399 );
+    mt19937_64 generator( 46 );
+    uniform_int_distribution<int64_t> offset( 0, ( last - first ).count( ) );
+    uniform_int_distribution<long> fraction( 0, 999'999'999 );
+    for( int i = 0; i < 100'000; ++i ) {
+        const sys_seconds point = first + seconds( i < 2 ? i * ( last - first ).count( ) : offset( generator ) );
+        const long nanoseconds = i % 2 == 0 ? 0 : fraction( generator );
+        const vtsu::DateTime date_time{ point + std::chrono::nanoseconds( nanoseconds ) };
+
+        const year_month_day ymd{ floor<days>( point ) };
+        const hh_mm_ss hms{ point - floor<days>( point ) };
+        const vtsu::Date expected_date( int( ymd.year( ) ), unsigned( ymd.month( ) ), unsigned( ymd.day( ) ) );
+        const vtsu::Time expected_time( hms.hours( ).count( ), hms.minutes( ).count( ), hms.seconds( ).count( ) );
+        if( date_time.get_date( ) != expected_date || date_time.get_time( ) != expected_time ||
+            date_time.get_nanoseconds( ) != nanoseconds ||
+            date_time.to_sys_time( ) != point + std::chrono::nanoseconds( nanoseconds ) ||
+            vtsu::DateTime( expected_date, expected_time, nanoseconds ) != date_time ) {
+            throw runtime_error( message_helper( "Conversion failed for " + full_string( date_time ), __FILE__, __LINE__ ) );
+        }
+    }
+
+    caught = false;
+    try {
+        vtsu::DateTime t4{ last + seconds( 1 ) };
+    }
+    catch( const vtsu::Date::OutOfRange & ) {
+        caught = true;
+    }
+    if( !caught ) {
+        throw runtime_error( message_helper( "Out of range time point accepted", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+// Parsing tests.
+void test2( )
+{
+    struct TestCase {
+        string             text;
+        vtsu::Date::Status expected_status;
+        string             expected;  // As written by full_string( ).
+    };
+
+    TestCase test_cases[] = {
+        { "2024-02-29T12:34:56Z",             vtsu::Date::Status::ok, "2024-02-29T12:34:56.000000000Z" },
+        { "2024-02-29T12:34:56",              vtsu::Date::Status::ok, "2024-02-29T12:34:56.000000000Z" },
+        { "2024-02-29 12:34:56",              vtsu::Date::Status::ok, "2024-02-29T12:34:56.000000000Z" },
+        { "2024-02-29t12:34:56z",             vtsu::Date::Status::ok, "2024-02-29T12:34:56.000000000Z" },
+        { "1950-01-01T00:00:00.5Z",           vtsu::Date::Status::ok, "1950-01-01T00:00:00.500000000Z" },
+        { "1969-12-31T23:59:59.123456789",    vtsu::Date::Status::ok, "1969-12-31T23:59:59.123456789Z" },
+        { "2199-12-31T23:59:59.9999999999Z",  vtsu::Date::Status::ok, "2199-12-31T23:59:59.999999999Z" },
+        { "1949-12-31T23:59:59Z",             vtsu::Date::Status::out_of_range, "" },
+        { "2200-01-01T00:00:00Z",             vtsu::Date::Status::out_of_range, "" },
+        { "2023-02-29T00:00:00Z",             vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T24:00:00Z",             vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T00:60:00Z",             vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T00:00:60Z",             vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T1:00:00Z",              vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T00:00:00.Z",            vtsu::Date::Status::invalid, "" },
+        { "2024-01-01T00:00:00+01:00",        vtsu::Date::Status::invalid, "" },
+        { "01/01/2024T00:00:00",              vtsu::Date::Status::invalid, "" },
+        { "2024-01-01",                       vtsu::Date::Status::invalid, "" },
+        { "",                                 vtsu::Date::Status::invalid, "" }
+    };
+
+    std::cout << "parse_date_times( ) ... ";
+    vector<string_view> strings;
+    for( const auto &test_case : test_cases ) {
+        strings.push_back( test_case.text );
+    }
+    vector<vtsu::DateTime> date_times( strings.size( ) );
+    vector<vtsu::Date::Status> statuses( strings.size( ) );
+    if( vtsu::parse_date_times( strings, date_times, statuses ) != 12 ) {
+        throw runtime_error( message_helper( "parse_date_times( ) failure count wrong", __FILE__, __LINE__ ) );
+    }
+    for( size_t i = 0; i < strings.size( ); ++i ) {
+        const TestCase &test_case = test_cases[i];
+        if( statuses[i] != test_case.expected_status ||
+            ( statuses[i] == vtsu::Date::Status::ok && full_string( date_times[i] ) != test_case.expected ) ) {
+            throw runtime_error( message_helper( "parse_date_times( ) failed for \"" + test_case.text + "\"", __FILE__, __LINE__ ) );
+        }
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "Constructor DateTime( std::string_view ) ... ";
+    if( vtsu::DateTime( "2024-02-29T12:34:56Z" ) != date_times[0] ) {
+        throw runtime_error( message_helper( "Constructor failed", __FILE__, __LINE__ ) );
+    }
+    int exceptions = 0;
+    for( const char *text : { "2024-02-30T00:00:00", "2200-01-01T00:00:00", "2024-01-01T00:00:00Zjunk" } ) {
+        try {
+            vtsu::DateTime t{ text };
+        }
+        catch( const vtsu::Date::Invalid & ) {
+            ++exceptions;
+        }
+        catch( const vtsu::Date::OutOfRange & ) {
+            exceptions += 10;
+        }
+    }
+    if( exceptions != 12 ) {
+        throw runtime_error( message_helper( "Constructor accepted an invalid string", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+// Formatting tests.
+void test3( )
+{
+    const vtsu::DateTime date_time{ vtsu::Date( 2024, 7, 4 ), vtsu::Time( 9U, 5U, 3U ), 120'000'000 };
+
+    std::cout << "to_chars( ) ... ";
+    struct TestCase {
+        int    fraction_digits;
+        string expected;
+    };
+    TestCase test_cases[] = {
+        {  0, "2024-07-04T09:05:03Z" },
+        {  1, "2024-07-04T09:05:03.1Z" },
+        {  3, "2024-07-04T09:05:03.120Z" },
+        {  9, "2024-07-04T09:05:03.120000000Z" },
+        { 12, "2024-07-04T09:05:03.120000000Z" },
+        { -1, "2024-07-04T09:05:03Z" }
+    };
+    for( const auto &test_case : test_cases ) {
+        char buffer[vtsu::date_time_chars];
+        auto result = vtsu::to_chars( buffer, buffer + sizeof( buffer ), date_time, test_case.fraction_digits );
+        if( result.ec != errc{ } || string( buffer, result.ptr ) != test_case.expected ) {
+            throw runtime_error( message_helper( "to_chars( ) test failed", __FILE__, __LINE__ ) );
+        }
+        result = vtsu::to_chars( buffer, buffer + test_case.expected.size( ) - 1, date_time, test_case.fraction_digits );
+        if( result.ec != errc::value_too_large ) {
+            throw runtime_error( message_helper( "to_chars( ) overflow test failed", __FILE__, __LINE__ ) );
+        }
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "operator<<( ) and operator>>( ) ... ";
+    const vtsu::DateTime whole{ vtsu::Date( 1955, 11, 5 ), vtsu::Time( 22U, 4U ) };
+    ostringstream output;
+    output << date_time << " " << whole;
+    if( output.str( ) != "2024-07-04T09:05:03.120000000Z 1955-11-05T22:04:00Z" ) {
+        throw runtime_error( message_helper( "operator<<( ) test failed", __FILE__, __LINE__ ) );
+    }
+    istringstream input( output.str( ) );
+    vtsu::DateTime first_read;
+    vtsu::DateTime second_read;
+    input >> first_read >> second_read;
+    if( !input || first_read != date_time || second_read != whole ) {
+        throw runtime_error( message_helper( "operator>>( ) test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "format_date_times( ) ... ";
+    const vtsu::DateTime date_times[] = { date_time, whole };
+    string text = "Log:\n";
+    vtsu::format_date_times( date_times, text, 3 );
+    if( text != "Log:\n2024-07-04T09:05:03.120Z\n1955-11-05T22:04:00.000Z\n" ) {
+        throw runtime_error( message_helper( "format_date_times( ) test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+// Arithmetic tests.
+void test4( )
+{
+    std::cout << "advance( ) and difference( ) ... ";
+    vtsu::DateTime date_time{ "1969-12-31T23:59:59.75Z" };
+    const vtsu::DateTime original = date_time;
+    date_time.advance( chrono::milliseconds( 500 ) );
+    if( date_time != vtsu::DateTime( "1970-01-01T00:00:00.25Z" ) ||
+        vtsu::difference( date_time, original ) != chrono::milliseconds( 500 ) ||
+        vtsu::difference( original, date_time ) != chrono::milliseconds( -500 ) ) {
+        throw runtime_error( message_helper( "advance( ) test failed", __FILE__, __LINE__ ) );
+    }
+    date_time.advance( -chrono::hours( 24 * 365 ) );
+    if( date_time != vtsu::DateTime( "1969-01-01T00:00:00.25Z" ) ) {
+        throw runtime_error( message_helper( "advance( ) test failed", __FILE__, __LINE__ ) );
+    }
+
+    bool caught = false;
+    try {
+        date_time.advance( chrono::nanoseconds( INT64_MAX ) );
+    }
+    catch( const vtsu::Date::OutOfRange & ) {
+        caught = true;
+    }
+    if( !caught || date_time != vtsu::DateTime( "1969-01-01T00:00:00.25Z" ) ) {
+        throw runtime_error( message_helper( "advance( ) range test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+// TimestampColumn tests.
+void test5( )
+{
+    std::cout << "TimestampColumn ... ";
+    const string_view strings[] = {
+        "2024-03-09T23:59:59.999Z", "2024-03-10T00:00:00Z", "2024-03-10T00:59:59Z",
+        "2024-03-10T01:00:00Z",     "2024-03-10T05:30:00Z", "2024-03-09T12:00:00Z",
+        "1969-12-31T23:00:00Z"
+    };
+    vtsu::TimestampColumn column;
+    for( string_view text : strings ) {
+        column.push_back( vtsu::DateTime( text ) );
+    }
+
+    const vtsu::DateTime origin{ "2024-03-10T00:00:00Z" };
+    vector<int64_t> buckets;
+    column.bucket( origin, chrono::hours( 1 ), buckets );
+    const vector<int64_t> expected_buckets = { -1, 0, 0, 1, 5, -12, -475'009 };
+    const vector<size_t> expected_counts = { 2, 1, 0, 0, 0, 1 };
+    if( buckets != expected_buckets || column.count_by_bucket( origin, chrono::hours( 1 ), 6 ) != expected_counts ) {
+        throw runtime_error( message_helper( "TimestampColumn::bucket( ) test failed", __FILE__, __LINE__ ) );
+    }
+
+    vector<int32_t> serials;
+    column.bucket_by_day( serials );
+    for( size_t i = 0; i < column.size( ); ++i ) {
+        if( serials[i] != column[i].get_date( ).get_serial( ) || column[i] != vtsu::DateTime( strings[i] ) ) {
+            throw runtime_error( message_helper( "TimestampColumn::bucket_by_day( ) test failed", __FILE__, __LINE__ ) );
+        }
+    }
+
+    if( column.count_between( origin, vtsu::DateTime( "2024-03-10T01:00:00Z" ) ) != 3 ||
+        column.count_between( vtsu::DateTime( "2024-03-10T01:00:00Z" ), origin ) != 0 ) {
+        throw runtime_error( message_helper( "TimestampColumn::count_between( ) test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+int main( )
+{
+    try {
+        test1( );  // Tests for constructors, accessors, and conversions.
+        test2( );  // Tests for parsing.
+        test3( );  // Tests for formatting.
+        test4( );  // Tests for advance( ) and difference( ).
+        test5( );  // Tests for TimestampColumn.
+        return EXIT_SUCCESS;
+    }
+    catch ( const exception &e ) {
+        cerr << "\n\nUnhandled exception: " << e.what( ) << endl;
+        return EXIT_FAILURE;
+    }
+    catch ( ... ) {
+        cerr << "\n\nUnknown exception" << endl;
+        return EXIT_FAILURE;
+    }
+}
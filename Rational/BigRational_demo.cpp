@@ -1,20 +1,41 @@
 /*! \file   BigRational_demo.cpp
  *  \brief  A more interesting demonstration of the Rational template.
  *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * With vtsu::BigInteger as the underlying type, rationals can't overflow. This program computes
+ * harmonic numbers H(n) = 1/1 + 1/2 + ... + 1/n exactly. The sums aren't reduced to lowest terms
+ * after every addition (see the lazy normalization described in Rational.hpp), which makes long
+ * sums like these much faster.
  */
 
 #include <cstdlib>
 #include <iostream>
 #include "Rational.hpp"
-#include "../BigInteger/BigInteger1.hpp"
+#include "../BigInteger/BigInteger4.hpp"
 
 using namespace std;
 
+using BigRational = vtsu::Rational<vtsu::BigInteger>;
+
+// Rationals can't be assigned, so the sum is built recursively.
+BigRational harmonic( unsigned n )
+{
+    if( n == 1 ) return BigRational{ 1 };
+    return harmonic( n - 1 ) + BigRational{ 1, n };
+}
+
 int main( )
 {
-    vtsu::Rational<vtsu::BigInteger> fraction_1{ 1, 2 };
+    BigRational fraction_1{ 1, 2 };
 
     cout << "fraction_1 = " << fraction_1 << endl;
+
+    for( unsigned n : { 10u, 50u, 100u } ) {
+        cout << "H(" << n << ") = " << harmonic( n ) << endl;
+    }
+    const BigRational h100 = harmonic( 100 );
+    cout << "H(100) > 5: " << boolalpha << ( h100 > BigRational{ 5 } ) << endl;
+    cout << "H(100) - H(99) = " << h100 - harmonic( 99 ) << endl;
     
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -6,18 +6,78 @@
 #ifndef RATIONAL_HPP
 #define RATIONAL_HPP
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <compare>
 #include <concepts>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace vtsu {
 
+    //! Types that can be used for the numerator and denominator of a Rational.
+    /*!
+     * These are the unsigned integer types and types that behave like unsigned integers with
+     * an unlimited range, such as vtsu::BigInteger (used only with non-negative values).
+     */
+    template<typename UIntType>
+    concept Rationalizable =
+        std::unsigned_integral<UIntType> ||
+        ( !std::is_arithmetic_v<UIntType> &&
+          std::regular<UIntType> &&
+          std::totally_ordered<UIntType> &&
+          std::constructible_from<UIntType, unsigned> &&
+          requires( UIntType a, UIntType b ) {
+              { a + b } -> std::convertible_to<UIntType>;
+              { a - b } -> std::convertible_to<UIntType>;
+              { a * b } -> std::convertible_to<UIntType>;
+              { a / b } -> std::convertible_to<UIntType>;
+              { a % b } -> std::convertible_to<UIntType>;
+          } );
+
+    //! Types with a fixed number of bits, so that arithmetic on them can overflow.
+    /*!
+     * Class types (such as vtsu::BigInteger) are assumed to have an unlimited range. Note that
+     * this includes compiler specific types such as unsigned __int128.
+     */
     template<typename UIntType>
-    concept Rationalizable = std::unsigned_integral<UIntType>;
+    concept FixedWidth = !std::is_class_v<UIntType>;
+
+    //! The unsigned integer types, including unsigned __int128 if the compiler provides it.
+    /*!
+     * Rationals of these types can be converted to and from characters. The 128 bit type is
+     * needed because promote( ) produces it from 64 bit rationals, but with -std=c++20 it isn't
+     * std::unsigned_integral and the standard library doesn't format or parse it.
+     */
+    template<typename UIntType>
+    concept UnsignedInteger =
+        std::unsigned_integral<UIntType>
+#if defined( __SIZEOF_INT128__ )
+        || std::same_as<UIntType, unsigned __int128>
+#endif
+        ;
+
+    //! Tag type used to construct a Rational from a numerator and denominator in lowest terms.
+    struct AlreadyReduced { };
+    inline constexpr AlreadyReduced already_reduced{ };
 
     //! A template for managing rational numbers.
     /*!
      * This class template represents rational numbers as a numerator and denominator. Only
-     * unsigned rationals are supported.
+     * unsigned rationals are supported. Values are always kept in lowest terms. The arithmetic
+     * operators throw std::overflow_error if a result can't be represented, rather than
+     * silently producing a wrong answer; see checked_add( ) and friends for versions that don't
+     * throw.
      * 
      * Instances of this class are "semi-immutable" meaning that they cannot be modified after
      * construction *except* by the input `operator>>` which is permitted to overwrite an existing
@@ -25,8 +85,17 @@ namespace vtsu {
      * constructor also exists, although it is only useful for variables that you intend to read
      * from input later.
      * 
+     * When UIntType has an unlimited range (for example, vtsu::BigInteger) there is no risk of
+     * overflow, and results are normalized "lazily." The arithmetic operators don't reduce their
+     * results to lowest terms, so a long sum doesn't pay for a GCD computation in every step.
+     * Instead a value is reduced when it is the result of a chain of `reduction_interval`
+     * operations, which keeps the numbers from growing without bound. Comparisons cross
+     * multiply, and the accessors and the output operator compute the lowest terms of a copy,
+     * so (as for other rationals) a const value is never modified and can be shared by several
+     * threads.
+     *
      * \tparam UIntType The type used to represent the numerator and denominator. This type must be
-     * an unsigned integer type.
+     * Rationalizable.
      */
     template<typename UIntType>
         requires Rationalizable<UIntType>
@@ -53,7 +122,31 @@ namespace vtsu {
         template<typename T>
         friend std::ostream &operator<<( std::ostream &os, const Rational<T> &rat );
 
+        // Like `operator>>`, from_chars needs to overwrite an existing value.
+        template<typename T>
+            requires UnsignedInteger<T>
+        friend std::from_chars_result from_chars( const char *first, const char *last, Rational<T> &rat );
+
+        // The arithmetic functions need the unreduced values of lazy rationals.
+        template<typename T>
+        friend std::optional<Rational<T>> checked_multiply( const Rational<T> &left, const Rational<T> &right );
+
+        template<typename T>
+        friend std::optional<Rational<T>> checked_divide( const Rational<T> &left, const Rational<T> &right );
+
+        template<typename T>
+        friend std::optional<Rational<T>>
+            checked_add_or_subtract( const Rational<T> &left, const Rational<T> &right, bool subtract );
+
+        template<typename T>
+        friend std::strong_ordering operator<=>( const Rational<T> &left, const Rational<T> &right );
+
     public:
+        //! True if results are reduced to lowest terms only when necessary; see above.
+        static constexpr bool is_lazy = !FixedWidth<UIntType>;
+
+        //! The length of a chain of operations after which a lazy result is reduced anyway.
+        static constexpr unsigned reduction_interval = 8;
 
         // Because this class is semi-immutable, the only way to set the value of a default-
         // constructed Rational is via `operator>>`.
@@ -63,153 +156,859 @@ namespace vtsu {
         // Constructor with a default value for the second parameter as a convenience. Notice that
         // this constructor can be used as an implicit conversion from UIntType to
         // Rational<UIntType>.
-        //
-        // TODO: Check for division by zero.
         Rational( UIntType n, UIntType d = 1 ) : numerator{ n }, denominator{ d }
-            { reduce( ); }
+            { check_denominator( ); reduce( ); }
+
+        // Constructor for values known to be in lowest terms already (the greatest common divisor
+        // of n and d is one and d is not zero). This skips the reduction. It is used by the
+        // arithmetic operators, which produce reduced results directly.
+        Rational( AlreadyReduced, UIntType n, UIntType d ) : numerator{ n }, denominator{ d }
+            { }
 
         // Deleted assignment operator.
         Rational &operator=( const Rational & ) = delete;
 
-        // Accessor methods.
+        // Accessor methods. These return the numerator and denominator in lowest terms.
         UIntType get_numerator( ) const
-            { return numerator; }
+            { return is_reduced( ) ? numerator : lowest_terms( ).first; }
 
         UIntType get_denominator( ) const
-            { return denominator; }
+            { return is_reduced( ) ? denominator : lowest_terms( ).second; }
 
     private:
+        struct NoCount { };
         UIntType numerator;
         UIntType denominator;
 
+        // The number of operations since this value (or its operands) were last reduced. Zero
+        // means the value is in lowest terms. This is only needed for lazy rationals.
+        [[no_unique_address]] std::conditional_t<is_lazy, unsigned, NoCount> pending{ };
+
+        bool is_reduced( ) const
+        {
+            if constexpr( is_lazy ) return pending == 0;
+            else return true;
+        }
+
+        // Returns the numerator and denominator in lowest terms without changing this value.
+        std::pair<UIntType, UIntType> lowest_terms( ) const;
+
+        // Constructs a lazy result without reducing it (unless the chain is long enough).
+        struct Unreduced { };
+        Rational( Unreduced, UIntType n, UIntType d, unsigned depth ) :
+            numerator{ std::move( n ) }, denominator{ std::move( d ) }
+        {
+            pending = depth;
+            if( depth >= reduction_interval ) normalize( );
+        }
+
+        static unsigned depth_after( const Rational &left, const Rational &right )
+            requires is_lazy
+            { return std::max( left.pending, right.pending ) + 1; }
+
         void reduce( );
+        void normalize( )
+        {
+            if constexpr( is_lazy ) {
+                if( pending != 0 ) {
+                    reduce( );
+                    pending = 0;
+                }
+            }
+        }
+
         void set( const UIntType &n, const UIntType &d )
-            { numerator = n; denominator = d; reduce( ); }
+        {
+            numerator = n;
+            denominator = d;
+            check_denominator( );
+            reduce( );
+            if constexpr( is_lazy ) pending = 0;
+        }
+
+        void check_denominator( ) const
+            { if( denominator == 0 ) throw std::domain_error( "Rational with a zero denominator" ); }
+
+    public:
+        //! Returns the exact value of a double.
+        /*!
+         * \throws std::domain_error if x is negative, infinite, or not a number.
+         * \throws std::overflow_error if the numerator or denominator is too large for UIntType.
+         */
+        static Rational from_double( double x )
+            requires std::unsigned_integral<UIntType>;
+
+        //! Returns the rational closest to x whose denominator is at most max_denominator.
+        /*!
+         * This uses the continued fraction expansion of x (the Stern-Brocot tree), so it takes
+         * time proportional to log( max_denominator ). For example, approximate( 3.14159, 1000 )
+         * is 355/113. If two rationals are equally close, the one with the smaller denominator
+         * is returned.
+         *
+         * \throws std::domain_error if x is negative, infinite, or not a number, or if
+         * max_denominator is zero.
+         * \throws std::overflow_error if x is too large for UIntType.
+         */
+        static Rational approximate( double x, UIntType max_denominator )
+            requires std::unsigned_integral<UIntType>;
     };
 
 
+    // Reduction
+    // ---------
+
+    // Find the greatest common divisor of a and b using the binary GCD algorithm (Stein's
+    // algorithm). This uses only shifts and subtractions and takes time proportional to the
+    // number of bits in the arguments, not their size. Notice that `a` and `b` are being passed
+    // by value. This is because they need to be modified without changing the arguments.
+    // By convention gcd( 0, b ) is b, so gcd( 0, 0 ) is 0.
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    UIntType gcd( UIntType a, UIntType b )
+    {
+        if( a == 0 ) return b;
+        if( b == 0 ) return a;
+
+        // The common factors of two are removed first and put back at the end.
+        const int shift = std::countr_zero( static_cast<UIntType>( a | b ) );
+        a >>= std::countr_zero( a );
+        while( b != 0 ) {
+            // Both a and b are odd here (after this shift), so b - a is even.
+            b >>= std::countr_zero( b );
+            if( a > b ) std::swap( a, b );
+            b -= a;
+        }
+        return static_cast<UIntType>( a << shift );
+    }
+
+    // Other types use Euclid's algorithm (with remainders, not repeated subtraction), which
+    // also takes a number of steps proportional to the number of bits in the arguments.
+    template<typename UIntType>
+        requires ( !std::unsigned_integral<UIntType> )
+    UIntType gcd( UIntType a, UIntType b )
+    {
+        while( b != UIntType( 0u ) ) {
+            UIntType remainder = a % b;
+            a = std::move( b );
+            b = std::move( remainder );
+        }
+        return a;
+    }
+
+    // This method reduces the rational to lowest terms. It is only used while a value is being
+    // constructed (or read by `operator>>`), so it doesn't make the class any less immutable.
+    template<typename UIntType>
+        requires Rationalizable<UIntType>
+    void Rational<UIntType>::reduce( )
+    {
+        // The denominator is never zero, so common_divisor isn't either. Zero becomes 0/1.
+        UIntType common_divisor = gcd( numerator, denominator );
+
+        numerator = numerator / common_divisor;
+        denominator = denominator / common_divisor;
+    }
+
+    template<typename UIntType>
+        requires Rationalizable<UIntType>
+    std::pair<UIntType, UIntType> Rational<UIntType>::lowest_terms( ) const
+    {
+        const UIntType common_divisor = gcd( numerator, denominator );
+        return { numerator / common_divisor, denominator / common_divisor };
+    }
+
+
+    // Checked Arithmetic
+    // ------------------
+
+    // These functions compute a result and return false, without changing `result`, if the
+    // result is too large for IntType. Types without a fixed width never overflow.
+
+    template<typename IntType>
+    bool checked_multiply( IntType a, IntType b, IntType &result )
+    {
+        if constexpr( !FixedWidth<IntType> ) {
+            result = a * b;
+            return true;
+        }
+        else {
+    #if defined( __GNUC__ ) || defined( __clang__ )
+        IntType product;
+        if( __builtin_mul_overflow( a, b, &product ) ) return false;
+        result = product;
+    #else
+        const IntType maximum = static_cast<IntType>( ~IntType( 0 ) );
+        if( b != 0 && a > maximum / b ) return false;
+        result = static_cast<IntType>( a * b );
+    #endif
+            return true;
+        }
+    }
+
+    template<typename IntType>
+    bool checked_add( IntType a, IntType b, IntType &result )
+    {
+        if constexpr( FixedWidth<IntType> ) {
+            const IntType maximum = static_cast<IntType>( ~IntType( 0 ) );
+            if( a > maximum - b ) return false;
+        }
+        result = static_cast<IntType>( a + b );
+        return true;
+    }
+
+    //! DoubleWidth<T>::type is an unsigned type with twice as many bits as T, if there is one.
+    /*!
+     * It is used for intermediate results that might not fit in T even when the final result
+     * does. If there is no wider type (for 64 bit types without compiler support for 128 bit
+     * integers) it is T itself, and some representable results are reported as overflows.
+     */
+    template<typename UIntType>
+    struct DoubleWidth { using type = UIntType; };
+
+    template<std::unsigned_integral UIntType> requires ( sizeof( UIntType ) == 1 )
+    struct DoubleWidth<UIntType> { using type = std::uint16_t; };
+
+    template<std::unsigned_integral UIntType> requires ( sizeof( UIntType ) == 2 )
+    struct DoubleWidth<UIntType> { using type = std::uint32_t; };
+
+    template<std::unsigned_integral UIntType> requires ( sizeof( UIntType ) == 4 )
+    struct DoubleWidth<UIntType> { using type = std::uint64_t; };
+
+#if defined( __SIZEOF_INT128__ )
+    template<std::unsigned_integral UIntType> requires ( sizeof( UIntType ) == 8 )
+    struct DoubleWidth<UIntType> { using type = unsigned __int128; };
+#endif
+
+
+    // The functions below compute results in lowest terms without forming the (possibly
+    // overflowing) unreduced products. Common factors are divided out of the operands first
+    // ("cross-reduction"), so intermediate values are no larger than necessary. They return an
+    // empty optional if the result can't be represented: it is too large for UIntType or (for
+    // subtraction) negative.
+    //
+    // For lazy rationals the unreduced products are exactly what is wanted. They can't
+    // overflow, and reducing them is left for later.
+
+    template<typename UIntType>
+    std::optional<Rational<UIntType>>
+        checked_multiply( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            return Rational<UIntType>{ typename Rational<UIntType>::Unreduced{ },
+                left.numerator * right.numerator,
+                left.denominator * right.denominator,
+                Rational<UIntType>::depth_after( left, right ) };
+        }
+        else {
+            const UIntType a = left.get_numerator( );
+            const UIntType b = left.get_denominator( );
+            const UIntType c = right.get_numerator( );
+            const UIntType d = right.get_denominator( );
+            if( a == 0 || c == 0 ) return Rational<UIntType>{ };
+
+            // Since a/b and c/d are in lowest terms, only a and d or c and b can have common
+            // factors. After they are removed the product is in lowest terms, so if it overflows
+            // the result can't be represented.
+            const UIntType g1 = gcd( a, d );
+            const UIntType g2 = gcd( c, b );
+            UIntType n;
+            UIntType m;
+            if( !checked_multiply<UIntType>( a / g1, c / g2, n ) ) return std::nullopt;
+            if( !checked_multiply<UIntType>( b / g2, d / g1, m ) ) return std::nullopt;
+            return Rational<UIntType>{ already_reduced, n, m };
+        }
+    }
+
+    template<typename UIntType>
+    std::optional<Rational<UIntType>>
+        checked_divide( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        if( right.numerator == UIntType( 0u ) ) throw std::domain_error( "Rational division by zero" );
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            return Rational<UIntType>{ typename Rational<UIntType>::Unreduced{ },
+                left.numerator * right.denominator,
+                left.denominator * right.numerator,
+                Rational<UIntType>::depth_after( left, right ) };
+        }
+        else {
+            const Rational<UIntType> reciprocal{
+                already_reduced, right.get_denominator( ), right.get_numerator( ) };
+            return checked_multiply( left, reciprocal );
+        }
+    }
+
+    // Adds or subtracts using the method in Knuth, TAOCP, Vol 2, 4.5.1. With g = gcd( b, d ),
+    // a/b + c/d = t / ( (b/g)*d ) where t = a*(d/g) + c*(b/g), and the only common factors left
+    // in that fraction are factors of g. The products making up t can be larger than UIntType
+    // even when the result isn't, so t is computed in a wider type.
+    template<typename UIntType>
+    std::optional<Rational<UIntType>>
+        checked_add_or_subtract( const Rational<UIntType> &left, const Rational<UIntType> &right, bool subtract )
+    {
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            UIntType left_term  = left.numerator * right.denominator;
+            UIntType right_term = right.numerator * left.denominator;
+            if( subtract && left_term < right_term ) return std::nullopt;
+            return Rational<UIntType>{ typename Rational<UIntType>::Unreduced{ },
+                subtract ? left_term - right_term : left_term + right_term,
+                left.denominator * right.denominator,
+                Rational<UIntType>::depth_after( left, right ) };
+        }
+        else {
+            using Work = typename DoubleWidth<UIntType>::type;
+            const UIntType b = left.get_denominator( );
+            const UIntType d = right.get_denominator( );
+            const UIntType g = gcd( b, d );
+
+            Work left_term;
+            Work right_term;
+            Work t;
+            if( !checked_multiply<Work>( left.get_numerator( ), d / g, left_term ) ) return std::nullopt;
+            if( !checked_multiply<Work>( right.get_numerator( ), b / g, right_term ) ) return std::nullopt;
+            if( subtract ) {
+                if( left_term < right_term ) return std::nullopt;
+                t = static_cast<Work>( left_term - right_term );
+            }
+            else if( !checked_add<Work>( left_term, right_term, t ) ) {
+                // Since t / g2 >= t / g and g fits in UIntType, the result would be too large.
+                return std::nullopt;
+            }
+            if( t == 0 ) return Rational<UIntType>{ };
+
+            // Reducing t modulo g first keeps the GCD computation in UIntType.
+            const UIntType g2 = gcd( static_cast<UIntType>( t % g ), g );
+            const Work n = t / g2;
+            UIntType m;
+            if( n > static_cast<UIntType>( ~UIntType( 0 ) ) ) return std::nullopt;
+            if( !checked_multiply<UIntType>( b / g, d / g2, m ) ) return std::nullopt;
+            return Rational<UIntType>{ already_reduced, static_cast<UIntType>( n ), m };
+        }
+    }
+
+    template<typename UIntType>
+    std::optional<Rational<UIntType>>
+        checked_add( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        return checked_add_or_subtract( left, right, false );
+    }
+
+    template<typename UIntType>
+    std::optional<Rational<UIntType>>
+        checked_subtract( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        return checked_add_or_subtract( left, right, true );
+    }
+
+
     // Arithmetic Operators
     // --------------------
 
+    // The operators throw std::overflow_error if the result is too large to represent. In that
+    // case the computation can be redone with a wider type; see promote( ) below.
+
     template<typename UIntType>
     Rational<UIntType> operator+( const Rational<UIntType> &left, const Rational<UIntType> &right )
     {
-        // TODO: Deal with overflow problems!
-        UIntType common_denominator = left.get_denominator( ) * right.get_denominator( );
-        UIntType new_numerator =
-            left.get_numerator( )  * right.get_denominator( ) +
-            right.get_numerator( ) * left.get_denominator( );
-        UIntType new_denominator = common_denominator;
-
-        return Rational{ new_numerator, new_denominator };
+        auto result = checked_add( left, right );
+        if( !result ) throw std::overflow_error( "Rational overflow in operator+" );
+        return *result;
     }
 
     template<typename UIntType>
     Rational<UIntType> operator-( const Rational<UIntType> &left, const Rational<UIntType> &right )
     {
-        // TODO: Deal with overflow problems!
-        UIntType common_denominator = left.get_denominator( ) * right.get_denominator( );
-        UIntType new_numerator =
-            left.get_numerator( )  * right.get_denominator( ) -
-            right.get_numerator( ) * left.get_denominator( );
-        UIntType new_denominator = common_denominator;
-    
-        return Rational{ new_numerator, new_denominator };
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            // Lazy subtraction can't overflow, so an empty result means the difference is
+            // negative. Comparing first would compute the same cross products twice.
+            auto result = checked_subtract( left, right );
+            if( !result ) throw std::domain_error( "Negative Rational result in operator-" );
+            return *result;
+        }
+        if( left < right ) throw std::domain_error( "Negative Rational result in operator-" );
+        auto result = checked_subtract( left, right );
+        if( !result ) throw std::overflow_error( "Rational overflow in operator-" );
+        return *result;
     }
 
     template<typename UIntType>
     Rational<UIntType> operator*( const Rational<UIntType> &left, const Rational<UIntType> &right )
     {
-        // TODO: Deal with overflow problems!
-        UIntType new_numerator = left.get_numerator( ) * right.get_numerator( );
-        UIntType new_denominator = left.get_denominator( ) * right.get_denominator( );
-
-        return Rational{ new_numerator, new_denominator };
+        auto result = checked_multiply( left, right );
+        if( !result ) throw std::overflow_error( "Rational overflow in operator*" );
+        return *result;
     }
 
-    // TODO: Check for division by zero.
     template<typename UIntType>
     Rational<UIntType> operator/( const Rational<UIntType> &left, const Rational<UIntType> &right )
     {
-        // TODO: Deal with overflow problems!
-        UIntType new_numerator = left.get_numerator( ) * right.get_denominator( );
-        UIntType new_denominator = left.get_denominator( ) * right.get_numerator( );
-
-        return Rational{ new_numerator, new_denominator };
+        auto result = checked_divide( left, right );
+        if( !result ) throw std::overflow_error( "Rational overflow in operator/" );
+        return *result;
     }
 
 
-    // Reduction
+    // Promotion
     // ---------
 
-    // Find the greatest common divisor of a and b using Euclid's algorithm. This function only
-    // works if a and b are positive. Notice that `a` and `b` are being passed by value. This is
-    // because they need to be modified without changing the arguments.
     template<typename UIntType>
+    using wider_t = typename DoubleWidth<UIntType>::type;
+
+    //! Converts a Rational to the next wider type. This can't overflow.
+    /*!
+     * This supports computations that start with a narrow type and switch to a wider one only
+     * if they overflow. For example:
+     *
+     *     if( auto sum = checked_add( x, y ) ) ... use *sum ...
+     *     else ... use promote( x ) + promote( y ) ...
+     */
+    template<typename UIntType>
+        requires ( !std::same_as<wider_t<UIntType>, UIntType> && Rationalizable<wider_t<UIntType>> )
+    Rational<wider_t<UIntType>> promote( const Rational<UIntType> &value )
+    {
+        return Rational<wider_t<UIntType>>{
+            already_reduced, value.get_numerator( ), value.get_denominator( ) };
+    }
+
+
+    // Relational Operators
+    // --------------------
+
+    // Rationals are always in lowest terms so equal values have identical representations.
+    // Lazy rationals are compared by cross multiplying instead, which can't overflow and is
+    // cheaper than reducing both values.
+    template<typename UIntType>
+    bool operator==( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            return ( left <=> right ) == 0;
+        }
+        else {
+            return left.get_numerator( ) == right.get_numerator( ) &&
+                   left.get_denominator( ) == right.get_denominator( );
+        }
+    }
+
+    // Compares a/b with c/d, where b and d are not zero. Comparing a*d with c*b can overflow.
+    // Instead the integer parts are compared and, if they are equal, the fractional parts are
+    // compared by comparing their reciprocals (with the order reversed). This is the continued
+    // fraction expansion of the two values, which takes a number of steps proportional to the
+    // number of bits in the values.
+    template<typename IntType>
+    std::strong_ordering compare_quotients( IntType a, IntType b, IntType c, IntType d )
+    {
+        while( true ) {
+            const IntType q1 = a / b;
+            const IntType q2 = c / d;
+            if( q1 != q2 ) return q1 <=> q2;
+
+            const IntType r1 = a % b;
+            const IntType r2 = c % d;
+            // A zero remainder is smaller than any other.
+            if( r1 == 0 || r2 == 0 ) return r1 <=> r2;
+
+            // r1/b < r2/d exactly when d/r2 < b/r1.
+            const IntType old_b = b;
+            a = d;
+            b = r2;
+            c = old_b;
+            d = r1;
+        }
+    }
+
+    // Lazy rationals can't overflow, so for them the cross products are compared directly.
+    template<typename UIntType>
+    std::strong_ordering operator<=>( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    {
+        if constexpr( Rational<UIntType>::is_lazy ) {
+            return left.numerator * right.denominator <=> right.numerator * left.denominator;
+        }
+        else {
+            return compare_quotients(
+                left.get_numerator( ), left.get_denominator( ), right.get_numerator( ), right.get_denominator( ) );
+        }
+    }
+
+
+    // Conversions From double
+    // -----------------------
+
+    // A finite, non-negative double is m * 2**e for some integers m (less than 2**53) and e. The
+    // exact value of x is used by both conversions below; for example 0.1 is not 1/10.
+    struct DoubleParts {
+        std::uint64_t mantissa;  // Odd, unless x is zero.
+        int           exponent;
+    };
+
+    inline DoubleParts split_double( double x )
+    {
+        if( !( x >= 0.0 ) || x == std::numeric_limits<double>::infinity( ) ) {
+            throw std::domain_error( "Rational from a negative, infinite, or NaN double" );
+        }
+        if( x == 0.0 ) return { 0, 0 };
+        int exponent;
+        const double fraction = std::frexp( x, &exponent );
+        std::uint64_t mantissa = static_cast<std::uint64_t>( std::ldexp( fraction, 64 ) );
+        exponent -= 64;
+        const int zeros = std::countr_zero( mantissa );
+        return { mantissa >> zeros, exponent + zeros };
+    }
+
+    template<typename UIntType>
+        requires Rationalizable<UIntType>
+    Rational<UIntType> Rational<UIntType>::from_double( double x )
         requires std::unsigned_integral<UIntType>
-    UIntType gcd( UIntType a, UIntType b )
     {
-        while( a != b ) {
-            if ( a > b )
-                a -= b;
-            else
-                b -= a;
+        constexpr int digits = std::numeric_limits<UIntType>::digits;
+        const auto [mantissa, exponent] = split_double( x );
+        if( mantissa == 0 ) return Rational{ };
+
+        // The mantissa is odd so m / 2**-e is in lowest terms.
+        const int bits = static_cast<int>( std::bit_width( mantissa ) );
+        if( exponent >= 0 ) {
+            if( bits + exponent > digits ) throw std::overflow_error( "Rational overflow in from_double" );
+            return Rational{ already_reduced, static_cast<UIntType>( UIntType( mantissa ) << exponent ), 1 };
         }
-        return a;
+        if( bits > digits || -exponent >= digits ) throw std::overflow_error( "Rational overflow in from_double" );
+        return Rational{ already_reduced, static_cast<UIntType>( mantissa ), static_cast<UIntType>( UIntType( 1 ) << -exponent ) };
     }
 
-    // This method reduces the rational to lowest terms. Although this method modifies the rational,
-    // it can still be part of an immutable class since it is only used during construction and is
-    // otherwise private.
+    // The continued fraction expansion of x = p/q is found with Euclid's algorithm. Its
+    // convergents h/k are the best approximations of x, so the answer is either the last
+    // convergent whose denominator (and numerator) are small enough or the "semiconvergent"
+    // between that convergent and the next one with the largest denominator allowed. The
+    // number of steps is proportional to the number of bits in max_denominator.
     template<typename UIntType>
         requires Rationalizable<UIntType>
-    void Rational<UIntType>::reduce( )
+    Rational<UIntType> Rational<UIntType>::approximate( double x, UIntType max_denominator )
+        requires std::unsigned_integral<UIntType>
     {
-        UIntType common_divisor = gcd( numerator, denominator );
+        static_assert( std::numeric_limits<UIntType>::digits <= 64, "approximate( ) requires at most 64 bits" );
+        if( max_denominator == 0 ) throw std::domain_error( "Rational with a zero denominator" );
+
+        // p and q are computed in the widest type available. If q would be too large, x is very
+        // small and it is rounded. With a 128 bit type, this happens only when x < 2**-74 and
+        // doesn't change the result. Without one, a 64 bit UIntType with a huge max_denominator
+        // might not give the closest approximation of a small x.
+        using Work = wider_t<std::uint64_t>;
+        constexpr int work_digits = std::numeric_limits<Work>::digits;
+        const auto [mantissa, exponent] = split_double( x );
+        const Work limit = static_cast<UIntType>( ~UIntType( 0 ) );
+        Work p = mantissa;
+        Work q = 1;
+        if( exponent >= 0 ) {
+            if( std::bit_width( mantissa ) + exponent > std::numeric_limits<UIntType>::digits ) {
+                throw std::overflow_error( "Rational overflow in approximate" );
+            }
+            p <<= exponent;
+        }
+        else if( -exponent < work_digits ) {
+            q <<= -exponent;
+        }
+        else {
+            const int shift = -exponent - ( work_digits - 1 );
+            p = ( shift > 64 ) ? 0 : ( ( p >> ( shift - 1 ) ) + 1 ) >> 1;
+            q <<= work_digits - 1;
+        }
 
-        numerator /= common_divisor;
-        denominator /= common_divisor;
+        // The convergents h1/k1 and h0/k0 (the one before), starting with 1/0 and 0/1.
+        Work h0 = 0, h1 = 1;
+        Work k0 = 1, k1 = 0;
+        while( q != 0 ) {
+            const Work a = p / q;
+            // The largest partial quotient that keeps the numerator and denominator in range.
+            Work largest = ( k1 == 0 ) ? a : ( max_denominator - k0 ) / k1;
+            if( h1 != 0 ) largest = std::min( largest, ( limit - h0 ) / h1 );
+            if( a > largest ) {
+                if( k1 == 0 ) throw std::overflow_error( "Rational overflow in approximate" );
+                // The semiconvergent with the largest allowed partial quotient is closer to x than
+                // h1/k1 if 2*largest > a. If 2*largest == a it is closer if (p % q) / q < k0 / k1.
+                const bool use_semiconvergent =
+                    ( largest > a - largest ) ||
+                    ( largest == a - largest && compare_quotients<Work>( p % q, q, k0, k1 ) < 0 );
+                if( use_semiconvergent ) {
+                    return Rational{ already_reduced,
+                        static_cast<UIntType>( h0 + largest * h1 ), static_cast<UIntType>( k0 + largest * k1 ) };
+                }
+                break;
+            }
+            const Work h = a * h1 + h0;
+            const Work k = a * k1 + k0;
+            h0 = h1; h1 = h;
+            k0 = k1; k1 = k;
+            const Work r = p % q;
+            p = q;
+            q = r;
+        }
+        return Rational{ already_reduced, static_cast<UIntType>( h1 ), static_cast<UIntType>( k1 ) };
     }
 
 
+    // Character Conversions
+    // ---------------------
 
-    // Relational Operators
-    // --------------------
+    // These functions are like std::from_chars and std::to_chars: they don't allocate memory,
+    // throw exceptions, or depend on the locale. They are much faster than the stream operators
+    // and are meant for programs that read or write large numbers of rationals.
 
-    template<typename UIntType>
-    auto operator<=>( const Rational<UIntType> &left, const Rational<UIntType> &right )
+    // Like std::from_chars and std::to_chars for a single unsigned integer, but they also work
+    // for unsigned __int128. That type is parsed directly and is formatted 19 digits at a time
+    // (the most that fit in a std::uint64_t).
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::from_chars_result integer_from_chars( const char *first, const char *last, T &value )
     {
-        return left.get_numerator( ) * right.get_denominator( )
-            <=> right.get_numerator( ) * left.get_denominator( );
+        if constexpr( std::unsigned_integral<T> ) {
+            return std::from_chars( first, last, value );
+        }
+        else {
+            const T largest = ~T( 0 );
+            const char *p = first;
+            T result = 0;
+            bool too_large = false;
+            for( ; p != last && *p >= '0' && *p <= '9'; ++p ) {
+                const unsigned digit = static_cast<unsigned>( *p - '0' );
+                if( result > ( largest - digit ) / 10 ) too_large = true;
+                else result = 10 * result + digit;
+            }
+            if( p == first ) return { first, std::errc::invalid_argument };
+            if( too_large ) return { p, std::errc::result_out_of_range };
+            value = result;
+            return { p, std::errc{ } };
+        }
+    }
+
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::to_chars_result integer_to_chars( char *first, char *last, T value )
+    {
+        if constexpr( std::unsigned_integral<T> ) {
+            return std::to_chars( first, last, value );
+        }
+        else {
+            constexpr std::uint64_t chunk = 10'000'000'000'000'000'000ULL;  // 10**19
+            std::uint64_t parts[3];
+            int count = 0;
+            do {
+                parts[count++] = static_cast<std::uint64_t>( value % chunk );
+                value /= chunk;
+            } while( value != 0 );
+
+            // The most significant part is written as usual, and the others with leading zeros.
+            auto result = std::to_chars( first, last, parts[--count] );
+            while( count > 0 && result.ec == std::errc{ } ) {
+                if( last - result.ptr < 19 ) return { last, std::errc::value_too_large };
+                char *const end = result.ptr + 19;
+                std::uint64_t part = parts[--count];
+                for( char *p = end; p != result.ptr; part /= 10 ) *--p = static_cast<char>( '0' + part % 10 );
+                result.ptr = end;
+            }
+            return result;
+        }
+    }
+
+    //! Parses a rational in the form n or n/d (exactly; no signs or spaces) from [first, last).
+    /*!
+     * \return On success, `ptr` points at the first character after the rational and `ec` is
+     * zero. If there is no valid rational at `first`, or if its denominator is zero, `ptr` is
+     * `first` and `ec` is std::errc::invalid_argument. If the numerator or denominator is too
+     * large for T, `ptr` points after the rational and `ec` is std::errc::result_out_of_range.
+     * In both error cases `rat` is not changed.
+     */
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::from_chars_result from_chars( const char *first, const char *last, Rational<T> &rat )
+    {
+        // std::from_chars would accept a leading '-' for a signed type, but not for T.
+        T numerator{ };
+        T denominator{ 1 };
+        auto [ptr, ec] = integer_from_chars( first, last, numerator );
+        if( ec == std::errc::invalid_argument ) return { first, ec };
+
+        std::errc denominator_ec{ };
+        if( ptr != last && *ptr == '/' ) {
+            auto [end, result] = integer_from_chars( ptr + 1, last, denominator );
+            if( result == std::errc::invalid_argument ) return { first, result };
+            ptr = end;
+            denominator_ec = result;
+        }
+        if( ec != std::errc{ } || denominator_ec != std::errc{ } ) {
+            return { ptr, std::errc::result_out_of_range };
+        }
+        if( denominator == 0 ) return { first, std::errc::invalid_argument };
+        rat.set( numerator, denominator );
+        return { ptr, std::errc{ } };
+    }
+
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::from_chars_result from_chars( std::string_view text, Rational<T> &rat )
+    {
+        return from_chars( text.data( ), text.data( ) + text.size( ), rat );
+    }
+
+    //! The largest number of characters written by to_chars for a Rational<T>.
+    template<typename T>
+        requires UnsignedInteger<T>
+    constexpr std::size_t max_chars = 2 * ( std::numeric_limits<T>::digits10 + 1 ) + 1;
+
+    //! Writes a rational as n or n/d (if d isn't one) into [first, last).
+    /*!
+     * \return On success, `ptr` points after the last character written and `ec` is zero. If
+     * there isn't enough space, `ptr` is `last` and `ec` is std::errc::value_too_large. No
+     * null character is written.
+     */
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::to_chars_result to_chars( char *first, char *last, const Rational<T> &rat )
+    {
+        auto result = integer_to_chars( first, last, rat.get_numerator( ) );
+        if( result.ec != std::errc{ } || rat.get_denominator( ) == 1 ) return result;
+        if( result.ptr == last ) return { last, std::errc::value_too_large };
+        *result.ptr = '/';
+        return integer_to_chars( result.ptr + 1, last, rat.get_denominator( ) );
+    }
+
+    //! Parses every rational in a buffer of text.
+    /*!
+     * The text must consist of rationals in the form n or n/d (see from_chars above) separated
+     * by white space or by commas. A comma may have spaces or tabs around it. This handles,
+     * for example, a CSV file where every field is a rational. Anything else is an error,
+     * including an empty field and a comma at the end of a line.
+     *
+     * \param consume A function that is called with each rational, in order.
+     * \return On success, `ptr` is the end of the text and `ec` is zero. Otherwise `ptr` points
+     * at the start of the invalid or out of range field and `ec` is as for from_chars. The
+     * rationals before that field have been consumed.
+     */
+    template<typename T, typename Consumer>
+        requires UnsignedInteger<T>
+    std::from_chars_result for_each_rational( std::string_view text, Consumer consume )
+    {
+        const char *p = text.data( );
+        const char *const end = p + text.size( );
+        const auto is_space = []( char ch ) {
+            return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f' || ch == '\v';
+        };
+        const auto is_blank = []( char ch ) { return ch == ' ' || ch == '\t'; };
+
+        while( p != end && is_space( *p ) ) ++p;
+        Rational<T> value;
+        while( p != end ) {
+            const char *field = p;
+            auto [next, ec] = from_chars( p, end, value );
+            if( ec != std::errc{ } ) return { field, ec };
+            p = next;
+            consume( std::as_const( value ) );
+
+            // A field must be followed by the end of the text, white space, or a comma.
+            if( p == end ) break;
+            if( !is_space( *p ) && *p != ',' ) return { field, std::errc::invalid_argument };
+            while( p != end && is_blank( *p ) ) ++p;
+            if( p != end && *p == ',' ) {
+                ++p;
+                while( p != end && is_blank( *p ) ) ++p;
+                // Another field must follow the comma on the same line.
+                if( p == end || is_space( *p ) || *p == ',' ) return { p, std::errc::invalid_argument };
+            }
+            else {
+                while( p != end && is_space( *p ) ) ++p;
+            }
+        }
+        return { end, std::errc{ } };
+    }
+
+    //! Parses every rational in a buffer of text and appends them to `values`.
+    /*!
+     * See for_each_rational( ) for the format and the return value.
+     */
+    template<typename T>
+        requires UnsignedInteger<T>
+    std::from_chars_result parse_rationals( std::string_view text, std::vector<Rational<T>> &values )
+    {
+        return for_each_rational<T>( text, [&values]( const Rational<T> &value ) {
+            values.push_back( value );
+        } );
     }
 
 
     // Rational I/O
     // ------------
 
+    // For the unsigned integer types (including unsigned __int128), input is strictly in the form n or n/d (leading white
+    // space is skipped). The stream's fail bit is set if the input isn't in that form, if the
+    // denominator is zero, or if a value is too large.
     template<typename T>
     std::istream &operator>>( std::istream &is, Rational<T> &rat )
     {
-        T    numerator;
-        T    denominator;
-        char dummy;
-    
-        // TODO: Enforce stricter formatting rules for the input (input validation).
-        // Perhaps the RE should be: \d+(/\d+)?
-        is >> numerator >> dummy >> denominator;
-        rat.set( numerator, denominator );
+        if constexpr( UnsignedInteger<T> ) {
+            // Collect the characters that might be part of the rational, stopping (without
+            // consuming it) at the first character that can't be. Leading zeros are dropped, so
+            // a field that doesn't fit in the buffer is too large for T. The rest of such a
+            // field is still consumed, so that it isn't read as another value.
+            char buffer[max_chars<T> + 1];
+            std::size_t count = 0;
+            std::size_t field_start = 0;
+            bool seen_slash = false;
+            bool too_long = false;
+            is >> std::ws;
+            while( true ) {
+                const auto next = is.peek( );
+                if( next == std::char_traits<char>::eof( ) ) break;
+                const char ch = static_cast<char>( next );
+                if( ch == '/' && !seen_slash ) {
+                    seen_slash = true;
+                }
+                else if( ch < '0' || ch > '9' ) {
+                    break;
+                }
+                is.get( );
+                if( ch != '/' && count == field_start + 1 && buffer[field_start] == '0' ) {
+                    --count;
+                }
+                if( count == sizeof( buffer ) ) {
+                    too_long = true;
+                    continue;
+                }
+                buffer[count++] = ch;
+                if( ch == '/' ) field_start = count;
+            }
+            if( too_long ) {
+                is.setstate( std::ios_base::failbit );
+            }
+            else {
+                auto [ptr, ec] = from_chars( buffer, buffer + count, rat );
+                if( ec != std::errc{ } || ptr != buffer + count ) is.setstate( std::ios_base::failbit );
+            }
+        }
+        else {
+            T    numerator;
+            T    denominator;
+            char dummy;
+
+            is >> numerator >> dummy >> denominator;
+            rat.set( numerator, denominator );
+        }
         return is;
     }
 
+    // For the unsigned integer types, the output is formatted with to_chars and then written as
+    // a single string, so the stream's field width and fill character apply to the whole value.
     template<typename T>
     std::ostream &operator<<( std::ostream &os, const Rational<T> &rat )
     {
-        // TODO: Honor requested formatting (field width, padding, etc.)
-        if( rat.denominator == 1 ) {
-            os << rat.numerator;
+        if constexpr( UnsignedInteger<T> ) {
+            char buffer[max_chars<T>];
+            auto result = to_chars( buffer, buffer + sizeof( buffer ), rat );
+            os << std::string_view( buffer, static_cast<std::size_t>( result.ptr - buffer ) );
         }
         else {
-            os << rat.numerator << "/" << rat.denominator;
+            // TODO: Honor requested formatting (field width, padding, etc.)
+            const auto [numerator, denominator] = rat.lowest_terms( );
+            if( denominator == 1 ) {
+                os << numerator;
+            }
+            else {
+                os << numerator << "/" << denominator;
+            }
         }
         return os;
     }
@@ -0,0 +1,438 @@
+/*! \file   RationalArray.hpp
+ *  \brief  A container for processing many rational numbers at once.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * A std::vector<Rational<T>> is a poor way to store millions of rationals. Rational objects
+ * can't be assigned, every one of them is reduced when it is constructed, and the numerators
+ * and denominators are interleaved in memory. A RationalArray stores the numerators and the
+ * denominators in two separate vectors (a "structure of arrays"). The batch operations below
+ * run simple loops over those vectors that the compiler can vectorize.
+ *
+ * The batch arithmetic operations do not reduce their results to lowest terms. Call reduce( )
+ * when lowest terms are needed, or (if the results are only compared or converted to double)
+ * not at all. Individual elements are returned as Rational objects, which are always reduced.
+ */
+
+#ifndef RATIONALARRAY_HPP
+#define RATIONALARRAY_HPP
+
+#include <charconv>
+#include <cmath>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Rational.hpp"
+
+namespace vtsu {
+
+    //! A resizable array of rational numbers stored as a structure of arrays.
+    /*!
+     * \tparam UIntType The type of the numerators and denominators. This must be an unsigned
+     * integer type (not a type with an unlimited range).
+     */
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    class RationalArray {
+    public:
+        using value_type = Rational<UIntType>;
+
+        //! Creates an empty array.
+        RationalArray( ) = default;
+
+        //! Creates an array of `count` zeros.
+        explicit RationalArray( std::size_t count ) :
+            numerators( count, UIntType( 0 ) ), denominators( count, UIntType( 1 ) ) { }
+
+        std::size_t size( ) const
+            { return numerators.size( ); }
+
+        bool empty( ) const
+            { return numerators.empty( ); }
+
+        void reserve( std::size_t count )
+            { numerators.reserve( count ); denominators.reserve( count ); }
+
+        void push_back( const Rational<UIntType> &value )
+        {
+            numerators.push_back( value.get_numerator( ) );
+            denominators.push_back( value.get_denominator( ) );
+        }
+
+        //! Returns element `index` in lowest terms. There is no bounds checking.
+        Rational<UIntType> operator[]( std::size_t index ) const
+            { return Rational<UIntType>{ numerators[index], denominators[index] }; }
+
+        //! Stores `value` in element `index`. There is no bounds checking.
+        void set( std::size_t index, const Rational<UIntType> &value )
+        {
+            numerators[index]   = value.get_numerator( );
+            denominators[index] = value.get_denominator( );
+        }
+
+        //! The (possibly unreduced) numerators and denominators.
+        const UIntType *numerator_data( ) const
+            { return numerators.data( ); }
+
+        const UIntType *denominator_data( ) const
+            { return denominators.data( ); }
+
+        //! Reduces every element to lowest terms.
+        void reduce( );
+
+        //! Converts every element to the nearest double.
+        std::vector<double> to_doubles( ) const;
+
+        //! Converts every element to the nearest double, reusing the space in `result`.
+        void to_doubles( std::vector<double> &result ) const;
+
+        //! Creates an array from non-negative doubles, all using the same denominator.
+        /*!
+         * Each value is rounded to the nearest multiple of 1/denominator and the results are
+         * reduced. For example, with a denominator of 1000 the value 0.1234 becomes 123/1000.
+         *
+         * \throws std::domain_error if a value is negative or not a number, or if the
+         * denominator is zero.
+         * \throws std::overflow_error if a value times the denominator is too large for UIntType.
+         */
+        static RationalArray from_doubles( const std::vector<double> &values, UIntType denominator );
+
+        //! Creates an array holding the exact values of non-negative doubles.
+        /*!
+         * See Rational<UIntType>::from_double( ) for the exceptions thrown.
+         */
+        static RationalArray from_doubles( const std::vector<double> &values );
+
+        //! Creates an array of the best approximations to non-negative doubles.
+        /*!
+         * Each element is the rational closest to the corresponding value with a denominator no
+         * larger than max_denominator. See Rational<UIntType>::approximate( ).
+         */
+        static RationalArray approximate( const std::vector<double> &values, UIntType max_denominator );
+
+        template<typename T>
+            requires std::unsigned_integral<T>
+        friend void add( const RationalArray<T> &left, const RationalArray<T> &right, RationalArray<T> &result );
+
+        template<typename T>
+            requires std::unsigned_integral<T>
+        friend void multiply( const RationalArray<T> &left, const RationalArray<T> &right, RationalArray<T> &result );
+
+        template<typename T>
+            requires std::unsigned_integral<T>
+        friend void compare(
+            const RationalArray<T> &left, const RationalArray<T> &right, std::vector<signed char> &result );
+
+    private:
+        std::vector<UIntType> numerators;
+        std::vector<UIntType> denominators;
+
+        // Operands below this limit can be multiplied, and two such products added, without
+        // overflow. The batch operations use a fast loop when all the operands are this small
+        // and fix up the other elements afterward.
+        static constexpr UIntType small_limit =
+            UIntType( 1 ) << ( std::numeric_limits<UIntType>::digits / 2 - 1 );
+
+        static void check_sizes( const RationalArray &left, const RationalArray &right )
+        {
+            if( left.size( ) != right.size( ) )
+                throw std::invalid_argument( "RationalArray operands have different sizes" );
+        }
+
+        // Makes this array the given size without initializing any new elements.
+        void resize_for_result( std::size_t count )
+        {
+            numerators.resize( count );
+            denominators.resize( count );
+        }
+    };
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    void RationalArray<UIntType>::reduce( )
+    {
+        UIntType *n = numerators.data( );
+        UIntType *d = denominators.data( );
+        const std::size_t count = size( );
+        for( std::size_t i = 0; i < count; ++i ) {
+            // The denominator is never zero, so g isn't either. Most pairs are already coprime
+            // and division is slow, so it is skipped when possible.
+            const UIntType g = gcd( n[i], d[i] );
+            if( g != 1 ) {
+                n[i] /= g;
+                d[i] /= g;
+            }
+        }
+    }
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    std::vector<double> RationalArray<UIntType>::to_doubles( ) const
+    {
+        std::vector<double> result;
+        to_doubles( result );
+        return result;
+    }
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    void RationalArray<UIntType>::to_doubles( std::vector<double> &result ) const
+    {
+        result.resize( size( ) );
+        const UIntType *n = numerators.data( );
+        const UIntType *d = denominators.data( );
+        double *r = result.data( );
+        const std::size_t count = size( );
+        for( std::size_t i = 0; i < count; ++i ) {
+            r[i] = static_cast<double>( n[i] ) / static_cast<double>( d[i] );
+        }
+    }
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    RationalArray<UIntType>
+        RationalArray<UIntType>::from_doubles( const std::vector<double> &values, UIntType denominator )
+    {
+        if( denominator == 0 ) throw std::domain_error( "RationalArray with a zero denominator" );
+
+        // 2**digits is exactly representable as a double, while the largest UIntType might not
+        // be, so the range check uses it instead.
+        const double limit = std::ldexp( 1.0, std::numeric_limits<UIntType>::digits );
+        const double scale = static_cast<double>( denominator );
+        RationalArray result;
+        result.numerators.resize( values.size( ) );
+        result.denominators.assign( values.size( ), denominator );
+
+        UIntType *n = result.numerators.data( );
+        const double *v = values.data( );
+        const std::size_t count = values.size( );
+        bool in_range = true;
+        for( std::size_t i = 0; i < count; ++i ) {
+            const double scaled = std::nearbyint( v[i] * scale );
+            // This is false for NaNs as well as for values out of range.
+            in_range &= ( scaled >= 0.0 && scaled < limit );
+            n[i] = in_range ? static_cast<UIntType>( scaled ) : UIntType( 0 );
+        }
+        if( !in_range ) {
+            for( std::size_t i = 0; i < count; ++i ) {
+                if( !( v[i] >= 0.0 ) ) throw std::domain_error( "RationalArray from a negative double" );
+            }
+            throw std::overflow_error( "RationalArray overflow in from_doubles" );
+        }
+        result.reduce( );
+        return result;
+    }
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    RationalArray<UIntType> RationalArray<UIntType>::from_doubles( const std::vector<double> &values )
+    {
+        RationalArray result;
+        result.reserve( values.size( ) );
+        for( double value : values ) {
+            result.push_back( Rational<UIntType>::from_double( value ) );
+        }
+        return result;
+    }
+
+
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    RationalArray<UIntType>
+        RationalArray<UIntType>::approximate( const std::vector<double> &values, UIntType max_denominator )
+    {
+        RationalArray result;
+        result.reserve( values.size( ) );
+        for( double value : values ) {
+            result.push_back( Rational<UIntType>::approximate( value, max_denominator ) );
+        }
+        return result;
+    }
+
+
+    //! Parses every rational in a buffer of text and appends them to `values`.
+    /*!
+     * See for_each_rational( ) in Rational.hpp for the format and the return value.
+     */
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    std::from_chars_result parse_rationals( std::string_view text, RationalArray<UIntType> &values )
+    {
+        return for_each_rational<UIntType>( text, [&values]( const Rational<UIntType> &value ) {
+            values.push_back( value );
+        } );
+    }
+
+
+    // Batch Operations
+    // ----------------
+
+    // Each operation first runs a branch-free loop over all elements, computing the results as if
+    // nothing could overflow, and also combining all the operands with bitwise OR. If that shows
+    // that every operand was small, the results are exact. Otherwise a second loop redoes the
+    // elements with large operands using the (slower) checked Rational operations.
+
+    // The three parameter versions store their results in an existing object, reusing its
+    // space. This avoids allocating (and touching) new memory for every batch. The result may be
+    // one of the operands (as in add( x, y, x )), but then the fallback loop would read operands
+    // that were already overwritten, so the results are computed in a temporary array instead.
+
+    //! Stores the element-wise sums of two arrays of the same size in `result`.
+    /*!
+     * \throws std::invalid_argument if the arrays have different sizes.
+     * \throws std::overflow_error if a sum is too large to represent.
+     */
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    void add( const RationalArray<UIntType> &left, const RationalArray<UIntType> &right, RationalArray<UIntType> &result )
+    {
+        RationalArray<UIntType>::check_sizes( left, right );
+        if( &result == &left || &result == &right ) {
+            RationalArray<UIntType> temporary;
+            add( left, right, temporary );
+            result = std::move( temporary );
+            return;
+        }
+        const std::size_t count = left.size( );
+        result.resize_for_result( count );
+
+        const UIntType *a = left.numerators.data( );
+        const UIntType *b = left.denominators.data( );
+        const UIntType *c = right.numerators.data( );
+        const UIntType *d = right.denominators.data( );
+        UIntType *n = result.numerators.data( );
+        UIntType *m = result.denominators.data( );
+        UIntType combined = 0;
+        for( std::size_t i = 0; i < count; ++i ) {
+            combined |= a[i] | b[i] | c[i] | d[i];
+            n[i] = a[i] * d[i] + c[i] * b[i];
+            m[i] = b[i] * d[i];
+        }
+
+        if( combined >= RationalArray<UIntType>::small_limit ) {
+            for( std::size_t i = 0; i < count; ++i ) {
+                if( ( a[i] | b[i] | c[i] | d[i] ) < RationalArray<UIntType>::small_limit ) continue;
+                result.set( i, left[i] + right[i] );
+            }
+        }
+    }
+
+    //! Returns the element-wise sums of two arrays of the same size.
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    RationalArray<UIntType> add( const RationalArray<UIntType> &left, const RationalArray<UIntType> &right )
+    {
+        RationalArray<UIntType> result;
+        add( left, right, result );
+        return result;
+    }
+
+    //! Stores the element-wise products of two arrays of the same size in `result`.
+    /*!
+     * \throws std::invalid_argument if the arrays have different sizes.
+     * \throws std::overflow_error if a product is too large to represent.
+     */
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    void multiply( const RationalArray<UIntType> &left, const RationalArray<UIntType> &right, RationalArray<UIntType> &result )
+    {
+        RationalArray<UIntType>::check_sizes( left, right );
+        if( &result == &left || &result == &right ) {
+            RationalArray<UIntType> temporary;
+            multiply( left, right, temporary );
+            result = std::move( temporary );
+            return;
+        }
+        const std::size_t count = left.size( );
+        result.resize_for_result( count );
+
+        const UIntType *a = left.numerators.data( );
+        const UIntType *b = left.denominators.data( );
+        const UIntType *c = right.numerators.data( );
+        const UIntType *d = right.denominators.data( );
+        UIntType *n = result.numerators.data( );
+        UIntType *m = result.denominators.data( );
+        UIntType combined = 0;
+        for( std::size_t i = 0; i < count; ++i ) {
+            combined |= a[i] | b[i] | c[i] | d[i];
+            n[i] = a[i] * c[i];
+            m[i] = b[i] * d[i];
+        }
+
+        if( combined >= RationalArray<UIntType>::small_limit ) {
+            for( std::size_t i = 0; i < count; ++i ) {
+                if( ( a[i] | b[i] | c[i] | d[i] ) < RationalArray<UIntType>::small_limit ) continue;
+                result.set( i, left[i] * right[i] );
+            }
+        }
+    }
+
+    //! Returns the element-wise products of two arrays of the same size.
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    RationalArray<UIntType> multiply( const RationalArray<UIntType> &left, const RationalArray<UIntType> &right )
+    {
+        RationalArray<UIntType> result;
+        multiply( left, right, result );
+        return result;
+    }
+
+    //! Compares two arrays of the same size element by element.
+    /*!
+     * \param result Set to -1, 0, or +1 for each element depending on whether the element of
+     * `left` is less than, equal to, or greater than the element of `right`.
+     * \throws std::invalid_argument if the arrays have different sizes.
+     */
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    void compare(
+        const RationalArray<UIntType> &left, const RationalArray<UIntType> &right, std::vector<signed char> &result )
+    {
+        RationalArray<UIntType>::check_sizes( left, right );
+        const std::size_t count = left.size( );
+        result.resize( count );
+
+        const UIntType *a = left.numerators.data( );
+        const UIntType *b = left.denominators.data( );
+        const UIntType *c = right.numerators.data( );
+        const UIntType *d = right.denominators.data( );
+        signed char *r = result.data( );
+        UIntType combined = 0;
+        for( std::size_t i = 0; i < count; ++i ) {
+            combined |= a[i] | b[i] | c[i] | d[i];
+            const UIntType x = a[i] * d[i];
+            const UIntType y = c[i] * b[i];
+            r[i] = static_cast<signed char>( ( x > y ) - ( x < y ) );
+        }
+
+        if( combined >= RationalArray<UIntType>::small_limit ) {
+            for( std::size_t i = 0; i < count; ++i ) {
+                if( ( a[i] | b[i] | c[i] | d[i] ) < RationalArray<UIntType>::small_limit ) continue;
+                const std::strong_ordering order = left[i] <=> right[i];
+                r[i] = static_cast<signed char>( ( order > 0 ) - ( order < 0 ) );
+            }
+        }
+    }
+
+    //! Returns the results of comparing two arrays of the same size element by element.
+    template<typename UIntType>
+        requires std::unsigned_integral<UIntType>
+    std::vector<signed char> compare( const RationalArray<UIntType> &left, const RationalArray<UIntType> &right )
+    {
+        std::vector<signed char> result;
+        compare( left, right, result );
+        return result;
+    }
+
+}
+
+#endif
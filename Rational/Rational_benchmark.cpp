@@ -0,0 +1,230 @@
+/*! \file   Rational_benchmark.cpp
+ *  \brief  A program that compares batch RationalArray operations with individual Rationals.
+ *  \author Peter Chapin <peter.chapin@vermontstate.edu>
+ *
+ * This program creates two batches of random Rational<std::uint64_t> values and measures the
+ * throughput of addition, multiplication, comparison, reduction, and conversion to double. Each
+ * operation is done both one Rational at a time (storing the results in a std::vector) and with
+ * the batch operations of RationalArray. Parsing and formatting text are also measured, using
+ * the stream operators in the first column and parse_rationals and to_chars in the second.
+ * Finally, the best approximations of random doubles with denominators up to 1000 are found by
+ * a linear search over the denominators and by RationalArray::approximate( ). Build with optimization (and vectorization) for
+ * meaningful results. For example:
+ *
+ *     make Rational_benchmark CXXFLAGS="-std=c++20 -O3 -march=native"
+ *
+ * The batch size can be given on the command line. The values have numerators and denominators
+ * below one million, so the batch operations take their fast path.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Rational.hpp"
+#include "RationalArray.hpp"
+
+using namespace std;
+
+using Rational64 = vtsu::Rational<uint64_t>;
+using Array64    = vtsu::RationalArray<uint64_t>;
+
+// Runs `operation` several times and returns the best time in seconds.
+template<typename Operation>
+double best_time( Operation operation )
+{
+    double best = 0.0;
+    for( int trial = 0; trial < 5; ++trial ) {
+        auto start = chrono::steady_clock::now( );
+        operation( );
+        auto end = chrono::steady_clock::now( );
+        chrono::duration<double> elapsed_seconds = end - start;
+        if( trial == 0 || elapsed_seconds.count( ) < best ) best = elapsed_seconds.count( );
+    }
+    return best;
+}
+
+void print_row( const char *operation, size_t count, double scalar_seconds, double batch_seconds )
+{
+    cout << setw( 12 ) << operation
+         << setw( 14 ) << fixed << setprecision( 1 ) << count / scalar_seconds / 1.0e6
+         << setw( 14 ) << count / batch_seconds / 1.0e6
+         << setw( 10 ) << setprecision( 2 ) << scalar_seconds / batch_seconds << "\n";
+}
+
+int main( int argc, char **argv )
+{
+    size_t count = 1'000'000;
+    if( argc > 1 ) count = static_cast<size_t>( atol( argv[1] ) );
+
+    mt19937_64 generator( 37 );
+    uniform_int_distribution<uint64_t> numerator( 0, 999'999 );
+    uniform_int_distribution<uint64_t> denominator( 1, 999'999 );
+
+    vector<Rational64> x;
+    vector<Rational64> y;
+    Array64 x_array;
+    Array64 y_array;
+    x.reserve( count );
+    y.reserve( count );
+    x_array.reserve( count );
+    y_array.reserve( count );
+    for( size_t i = 0; i < count; ++i ) {
+        x.emplace_back( numerator( generator ), denominator( generator ) );
+        y.emplace_back( numerator( generator ), denominator( generator ) );
+        x_array.push_back( x.back( ) );
+        y_array.push_back( y.back( ) );
+    }
+
+    // Results are kept so that the work can't be optimized away. Rationals can't be assigned,
+    // so each scalar trial builds a new vector.
+    vector<Rational64> scalar_result;
+    vector<signed char> scalar_order( count );
+    vector<double> scalar_doubles( count );
+    Array64 batch_result;
+    vector<signed char> batch_order;
+    vector<double> batch_doubles;
+
+    cout << "Throughput in millions of values per second (" << count << " values)\n";
+    cout << setw( 12 ) << "Operation" << setw( 14 ) << "Rational" << setw( 14 ) << "RationalArray"
+         << setw( 10 ) << "Speedup" << "\n";
+
+    // The scalar operations reduce every result, so they are compared with a batch operation
+    // followed by a batch reduction.
+    double scalar = best_time( [&] {
+        vector<Rational64> result;
+        result.reserve( count );
+        for( size_t i = 0; i < count; ++i ) result.push_back( x[i] + y[i] );
+        scalar_result.swap( result );
+    } );
+    double batch = best_time( [&] { add( x_array, y_array, batch_result ); batch_result.reduce( ); } );
+    print_row( "add+reduce", count, scalar, batch );
+    batch = best_time( [&] { add( x_array, y_array, batch_result ); } );
+    print_row( "add", count, scalar, batch );
+
+    scalar = best_time( [&] {
+        vector<Rational64> result;
+        result.reserve( count );
+        for( size_t i = 0; i < count; ++i ) result.push_back( x[i] * y[i] );
+        scalar_result.swap( result );
+    } );
+    batch = best_time( [&] { multiply( x_array, y_array, batch_result ); batch_result.reduce( ); } );
+    print_row( "mul+reduce", count, scalar, batch );
+    batch = best_time( [&] { multiply( x_array, y_array, batch_result ); } );
+    print_row( "mul", count, scalar, batch );
+
+    scalar = best_time( [&] {
+        for( size_t i = 0; i < count; ++i ) {
+            const strong_ordering order = x[i] <=> y[i];
+            scalar_order[i] = static_cast<signed char>( ( order > 0 ) - ( order < 0 ) );
+        }
+    } );
+    batch = best_time( [&] { compare( x_array, y_array, batch_order ); } );
+    print_row( "compare", count, scalar, batch );
+
+    scalar = best_time( [&] {
+        for( size_t i = 0; i < count; ++i ) {
+            scalar_doubles[i] = static_cast<double>( x[i].get_numerator( ) ) /
+                                static_cast<double>( x[i].get_denominator( ) );
+        }
+    } );
+    batch = best_time( [&] { x_array.to_doubles( batch_doubles ); } );
+    print_row( "to_doubles", count, scalar, batch );
+
+    // The text is one rational per line, as in a CSV file with one column.
+    string text;
+    for( size_t i = 0; i < count; ++i ) {
+        char buffer[vtsu::max_chars<uint64_t>];
+        auto result = to_chars( buffer, buffer + sizeof( buffer ), x[i] );
+        text.append( buffer, result.ptr );
+        text.push_back( '\n' );
+    }
+    vector<Rational64> parsed;
+    Array64 batch_parsed;
+    scalar = best_time( [&] {
+        istringstream input( text );
+        vector<Rational64> result;
+        result.reserve( count );
+        Rational64 value;
+        while( input >> value ) result.push_back( value );
+        parsed.swap( result );
+    } );
+    batch = best_time( [&] {
+        Array64 result;
+        result.reserve( count );
+        parse_rationals( text, result );
+        batch_parsed = std::move( result );
+    } );
+    print_row( "parse", count, scalar, batch );
+
+    string scalar_text;
+    string batch_text;
+    scalar = best_time( [&] {
+        ostringstream output;
+        for( size_t i = 0; i < count; ++i ) output << x[i] << '\n';
+        scalar_text = output.str( );
+    } );
+    batch = best_time( [&] {
+        batch_text.resize( count * ( vtsu::max_chars<uint64_t> + 1 ) );
+        char *p = batch_text.data( );
+        char *const end = p + batch_text.size( );
+        for( size_t i = 0; i < count; ++i ) {
+            p = to_chars( p, end, x[i] ).ptr;
+            *p++ = '\n';
+        }
+        batch_text.resize( static_cast<size_t>( p - batch_text.data( ) ) );
+    } );
+    print_row( "format", count, scalar, batch );
+
+    // The linear search is slow, so it is timed on fewer values.
+    vector<double> reals( count );
+    uniform_real_distribution<double> real( 0.0, 10.0 );
+    for( auto &value : reals ) value = real( generator );
+    const uint64_t max_denominator = 1000;
+    const size_t search_count = min( count, size_t( 10'000 ) );
+    vector<Rational64> searched;
+    Array64 approximations;
+    scalar = best_time( [&] {
+        vector<Rational64> result;
+        result.reserve( search_count );
+        for( size_t i = 0; i < search_count; ++i ) {
+            uint64_t best_n = 0;
+            uint64_t best_d = 1;
+            double best_error = reals[i];
+            for( uint64_t d = 1; d <= max_denominator; ++d ) {
+                const uint64_t n = static_cast<uint64_t>( reals[i] * d + 0.5 );
+                const double error = abs( reals[i] - static_cast<double>( n ) / d );
+                if( error < best_error ) { best_error = error; best_n = n; best_d = d; }
+            }
+            result.emplace_back( best_n, best_d );
+        }
+        searched.swap( result );
+    } ) * count / search_count;
+    batch = best_time( [&] { approximations = Array64::approximate( reals, max_denominator ); } );
+    print_row( "approximate", count, scalar, batch );
+
+    // Check that both methods agree. The linear search uses floating point arithmetic, so it
+    // isn't checked.
+    if( parsed.size( ) != count || batch_parsed.size( ) != count || scalar_text != text || batch_text != text ) {
+        cerr << "Text mismatch\n";
+        return EXIT_FAILURE;
+    }
+    multiply( x_array, y_array, batch_result );
+    batch_result.reduce( );
+    compare( x_array, y_array, batch_order );
+    for( size_t i = 0; i < count; ++i ) {
+        if( !( batch_result[i] == scalar_result[i] ) || batch_order[i] != scalar_order[i] ||
+            batch_doubles[i] != scalar_doubles[i] || !( parsed[i] == x[i] ) || !( batch_parsed[i] == x[i] ) ) {
+            cerr << "Mismatch at element " << i << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
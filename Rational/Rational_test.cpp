@@ -0,0 +1,157 @@
+/*! \file    Rational_test.cpp
+ *  \brief   Test program for vtsu::Rational.
+ *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "Rational.hpp"
+
+using namespace std;
+
+// Helper function to generate a message string that includes the file name and line number.
+string message_helper( const string &message, const string &file, int line )
+{
+    return message + " (" + file + ":" + to_string( line ) + ")";
+}
+
+
+// Stream input tests.
+void test_input( )
+{
+    std::cout << "operator>> ... ";
+
+    struct TestCase {
+        string        text;
+        bool          ok;
+        std::uint64_t numerator;
+        std::uint64_t denominator;
+        string        rest;         // The characters left in the stream.
+    };
+
+    const string zeros( 45, '0' );
+    const string digits( 45, '7' );
+    TestCase test_cases[] = {
+        { "3/4 5"                                  , true , 3, 4, " 5"   },
+        { "  42"                                   , true , 42, 1, ""    },
+        { "0/7"                                    , true , 0, 1, ""     },
+        { "000"                                    , true , 0, 1, ""     },
+        { "18446744073709551615/2,"                , true , 18446744073709551615ULL, 2, "," },
+        { zeros + "1/3 7/2"                        , true , 1, 3, " 7/2" },
+        { "2/" + zeros + "6 7/2"                   , true , 1, 3, " 7/2" },
+        { zeros + zeros + "/" + zeros + "9 7/2"    , true , 0, 1, " 7/2" },
+        { "18446744073709551616"                   , false, 0, 0, ""     },
+        { digits + " 7/2"                          , false, 0, 0, " 7/2" },
+        { "1/" + digits + " 7/2"                   , false, 0, 0, " 7/2" },
+        { "1/" + digits + "/2 7/2"                 , false, 0, 0, "/2 7/2" },
+        { "1/0"                                    , false, 0, 0, ""     },
+        { "/3"                                     , false, 0, 0, ""     },
+        { "x"                                      , false, 0, 0, "x"    },
+    };
+
+    for( const auto &test_case : test_cases ) {
+        istringstream input( test_case.text );
+        vtsu::Rational<std::uint64_t> value{ 5, 6 };
+        input >> value;
+        if( !input.fail( ) != test_case.ok ) {
+            throw runtime_error( message_helper( "Wrong state after reading \"" + test_case.text + "\"", __FILE__, __LINE__ ) );
+        }
+        if( test_case.ok &&
+            ( value.get_numerator( ) != test_case.numerator || value.get_denominator( ) != test_case.denominator ) ) {
+            throw runtime_error( message_helper( "Wrong value read from \"" + test_case.text + "\"", __FILE__, __LINE__ ) );
+        }
+        input.clear( );
+        string rest( istreambuf_iterator<char>( input ), { } );
+        if( rest != test_case.rest ) {
+            throw runtime_error( message_helper( "Wrong characters consumed from \"" + test_case.text + "\"", __FILE__, __LINE__ ) );
+        }
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "operator>> (sequence) ... ";
+    istringstream input( "00000000000000000000000000000000000000000000001/3 7/2" );
+    vtsu::Rational<std::uint64_t> first;
+    vtsu::Rational<std::uint64_t> second;
+    input >> first >> second;
+    if( !input || first != vtsu::Rational<std::uint64_t>{ 1, 3 } || second != vtsu::Rational<std::uint64_t>{ 7, 2 } ) {
+        throw runtime_error( message_helper( "Sequence of values read incorrectly", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+// Promotion tests. The promoted values are printed and parsed, which (for 64 bit rationals)
+// needs the support for unsigned __int128 in the character conversions.
+void test_promote( )
+{
+#if defined( __SIZEOF_INT128__ )
+    std::cout << "promote( ) ... ";
+    const std::uint64_t largest = 18446744073709551615ULL;
+    const vtsu::Rational<std::uint64_t> x{ largest, 2 };
+    const vtsu::Rational<std::uint64_t> y{ largest - 2, 3 };
+    if( vtsu::checked_add( x, y ) ) {
+        throw runtime_error( message_helper( "checked_add( ) didn't overflow", __FILE__, __LINE__ ) );
+    }
+    const auto sum = vtsu::promote( x ) + vtsu::promote( y );
+
+    // (2**64 - 1)/2 + (2**64 - 3)/3 = (5*2**64 - 9)/6
+    ostringstream output;
+    output << sum;
+    if( output.str( ) != "92233720368547758071/6" ) {
+        throw runtime_error( message_helper( "Promoted value printed incorrectly", __FILE__, __LINE__ ) );
+    }
+
+    // The largest values use all three 19 digit parts of the formatting.
+    const unsigned __int128 all_ones = ~static_cast<unsigned __int128>( 0 );
+    const vtsu::Rational<unsigned __int128> big{ all_ones, 2 };
+    char buffer[vtsu::max_chars<unsigned __int128>];
+    auto [end, ec] = vtsu::to_chars( buffer, buffer + sizeof( buffer ), big );
+    const string text( buffer, end );
+    if( ec != std::errc{ } || text != "340282366920938463463374607431768211455/2" ) {
+        throw runtime_error( message_helper( "to_chars( ) failed for unsigned __int128", __FILE__, __LINE__ ) );
+    }
+    if( vtsu::to_chars( buffer, buffer + text.size( ) - 1, big ).ec != std::errc::value_too_large ) {
+        throw runtime_error( message_helper( "to_chars( ) overflowed its buffer", __FILE__, __LINE__ ) );
+    }
+
+    vtsu::Rational<unsigned __int128> parsed;
+    if( vtsu::from_chars( text, parsed ).ec != std::errc{ } || parsed != big ) {
+        throw runtime_error( message_helper( "from_chars( ) failed for unsigned __int128", __FILE__, __LINE__ ) );
+    }
+    if( vtsu::from_chars( "340282366920938463463374607431768211456", parsed ).ec != std::errc::result_out_of_range ) {
+        throw runtime_error( message_helper( "from_chars( ) accepted a value that is too large", __FILE__, __LINE__ ) );
+    }
+
+    istringstream input( "100000000000000000000000000000000000000/7 x" );
+    input >> parsed;
+    output.str( "" );
+    output << parsed;
+    if( !input || output.str( ) != "100000000000000000000000000000000000000/7" ) {
+        throw runtime_error( message_helper( "operator>> failed for unsigned __int128", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+#endif
+}
+
+
+int main( )
+{
+    try {
+        test_input( );    // Tests for operator>>( )
+        test_promote( );  // Tests for promote( ) and the 128 bit conversions.
+        return EXIT_SUCCESS;
+    }
+    catch ( const exception &e ) {
+        cerr << "\n\nUnhandled exception: " << e.what( ) << endl;
+        return EXIT_FAILURE;
+    }
+    catch ( ... ) {
+        cerr << "\n\nUnknown exception" << endl;
+        return EXIT_FAILURE;
+    }
+}
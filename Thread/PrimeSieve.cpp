@@ -0,0 +1,461 @@
+/*! \file    PrimeSieve.cpp
+ *  \brief   Implementation of a segmented, multithreaded Sieve of Eratosthenes.
+ *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PrimeSieve.hpp"
+
+namespace vtsu {
+
+    namespace {
+
+        const std::uint64_t segment_bits = 8 * PrimeSieve::segment_bytes;
+
+        // Returns the largest integer whose square is no larger than n.
+        std::uint64_t integer_sqrt( std::uint64_t n )
+        {
+            // The estimate can be off by one in either direction. The squares are compared by
+            // dividing instead of multiplying, so that nothing overflows when n is near 2**64.
+            std::uint64_t root = static_cast<std::uint64_t>( std::sqrt( static_cast<double>( n ) ) );
+            while( root != 0 && root > n / root ) --root;
+            while( root + 1 <= n / ( root + 1 ) ) ++root;
+            return root;
+        }
+
+        // Clears the bits of the composite numbers in bits [first_bit, last_bit). Bit i stands
+        // for the number 2 * i + 1. The bits are stored starting at `words`, so bit first_bit is
+        // bit 0 of words[0]; first_bit must be a multiple of 64.
+        void sieve_segment( std::uint64_t *words,
+                            std::uint64_t first_bit,
+                            std::uint64_t last_bit,
+                            const std::vector<std::uint32_t> &base_primes )
+        {
+            const std::uint64_t low  = 2 * first_bit + 1;  // The smallest number in the segment.
+            const std::uint64_t high = 2 * last_bit + 1;   // One past the largest.
+
+            for( std::uint64_t p : base_primes ) {
+                // Start at the first odd multiple of p in the segment, but not before p * p
+                // (smaller multiples have smaller prime factors and are already crossed out).
+                std::uint64_t multiple = p * p;
+                if( multiple >= high ) break;
+                if( multiple < low ) {
+                    multiple = ( low + p - 1 ) / p * p;
+                    if( multiple % 2 == 0 ) multiple += p;
+                }
+                // Consecutive odd multiples are 2p apart, which is p bits apart.
+                for( std::uint64_t bit = ( multiple - 1 ) / 2 - first_bit; bit < last_bit - first_bit; bit += p ) {
+                    words[bit / 64] &= ~( std::uint64_t( 1 ) << ( bit % 64 ) );
+                }
+            }
+        }
+
+        // Returns a mask of the bits at or above position `first` (0 .. 64) of a word.
+        inline std::uint64_t bits_from( unsigned first )
+        {
+            return first >= 64 ? 0 : ~std::uint64_t( 0 ) << first;
+        }
+
+        // Counts the set bits in [first_bit, last_bit) of the bits stored starting at `words`
+        // (where words[0] holds bit 0). Whole words are counted with std::popcount, which
+        // compiles to a single instruction on most processors. Only the words at the ends of
+        // the range need masks.
+        std::uint64_t count_bits( const std::uint64_t *words, std::uint64_t first_bit, std::uint64_t last_bit )
+        {
+            if( first_bit >= last_bit ) return 0;
+            const std::uint64_t first_word = first_bit / 64;
+            const std::uint64_t last_word  = ( last_bit - 1 ) / 64;
+            const std::uint64_t first_mask = bits_from( first_bit % 64 );
+            const std::uint64_t last_mask  = ~bits_from( static_cast<unsigned>( ( last_bit - 1 ) % 64 + 1 ) );
+            if( first_word == last_word ) {
+                return static_cast<std::uint64_t>( std::popcount( words[first_word] & first_mask & last_mask ) );
+            }
+            std::uint64_t count = static_cast<std::uint64_t>( std::popcount( words[first_word] & first_mask ) );
+            for( std::uint64_t word = first_word + 1; word < last_word; ++word ) {
+                count += static_cast<std::uint64_t>( std::popcount( words[word] ) );
+            }
+            return count + static_cast<std::uint64_t>( std::popcount( words[last_word] & last_mask ) );
+        }
+
+        // Returns the bit that stands for the smallest odd number >= n.
+        inline std::uint64_t bit_at_or_above( std::uint64_t n )
+        {
+            return n / 2;
+        }
+
+        // Returns the bit after the one that stands for the largest odd number <= n.
+        inline std::uint64_t bit_after( std::uint64_t n )
+        {
+            return n / 2 + ( n & 1 );  // That is, ( n + 1 ) / 2 without overflowing.
+        }
+
+        // The largest value of `high` accepted by PrimeRange and count_primes( ). Beyond it the
+        // arithmetic on the numbers in a segment (such as 2 * bit + 1) can overflow.
+        const std::uint64_t maximum_high = ( std::uint64_t( 1 ) << 63 ) - 1;
+
+        // Returns high, or throws std::out_of_range if it is larger than maximum_high.
+        std::uint64_t checked_high( std::uint64_t high, const char *where )
+        {
+            if( high > maximum_high ) throw std::out_of_range( std::string( "Upper bound of 2**63 or more in " ) + where );
+            return high;
+        }
+
+        // Sieves one segment of a window of numbers that isn't stored in a table. The segment
+        // is bits [first_bit, last_bit), where first_bit is a multiple of 64. The bits of the
+        // odd primes in the segment are left set in `words`; all others are cleared, including
+        // the bits outside of the window [window_first_bit, window_last_bit).
+        void sieve_window_segment( std::vector<std::uint64_t> &words,
+                                   std::uint64_t first_bit,
+                                   std::uint64_t last_bit,
+                                   std::uint64_t window_first_bit,
+                                   std::uint64_t window_last_bit,
+                                   const std::vector<std::uint32_t> &base_primes )
+        {
+            words.assign( ( last_bit - first_bit + 63 ) / 64, ~std::uint64_t( 0 ) );
+            sieve_segment( words.data( ), first_bit, last_bit, base_primes );
+            if( first_bit == 0 ) words[0] &= ~std::uint64_t( 1 );  // 1 isn't prime.
+            if( window_first_bit > first_bit ) {
+                words[0] &= bits_from( static_cast<unsigned>( window_first_bit - first_bit ) );
+            }
+            const std::uint64_t end = std::min( last_bit, window_last_bit ) - first_bit;
+            for( std::uint64_t word = end / 64; word < words.size( ); ++word ) {
+                words[word] &= ( word == end / 64 ) ? ~bits_from( end % 64 ) : 0;
+            }
+        }
+
+        // Divides bits [first_bit, last_bit) into segments and calls
+        //
+        //     sieve_one( segment_first_bit, segment_last_bit, words )
+        //
+        // for each of them, using up to `thread_count` threads (including the calling thread).
+        // The `words` vector belongs to the calling thread and can be used as a buffer. Returns
+        // the sum of the values returned by sieve_one. Segments begin on multiples of 64 bits
+        // (except perhaps the first), so no two threads ever write the same word of a table.
+        //
+        // Each thread takes the next unsieved segment until there are none left, or until a
+        // stop is requested. The progress object, if there is one, is updated after each
+        // segment. It is only read by other threads, so updating it costs a few uncontended
+        // atomic additions per segment.
+        template<typename SieveOne>
+        std::uint64_t for_each_segment( std::uint64_t first_bit,
+                                        std::uint64_t last_bit,
+                                        unsigned      thread_count,
+                                        SieveProgress *progress,
+                                        std::stop_token stop,
+                                        SieveOne sieve_one )
+        {
+            const std::uint64_t aligned_first_bit = first_bit / 64 * 64;
+            const std::uint64_t segment_count =
+                ( last_bit > first_bit ) ? ( last_bit - aligned_first_bit + segment_bits - 1 ) / segment_bits : 0;
+            const unsigned worker_count =
+                static_cast<unsigned>( std::max<std::uint64_t>( 1, std::min<std::uint64_t>( thread_count, segment_count ) ) );
+            if( progress != nullptr ) progress->start( segment_count, worker_count );
+
+            std::atomic<std::uint64_t> next_segment{ 0 };
+            std::atomic<std::uint64_t> completed{ 0 };
+            std::atomic<std::uint64_t> total{ 0 };
+            auto worker = [&]( unsigned index ) {
+                std::vector<std::uint64_t> words;
+                std::uint64_t local_count = 0;
+                std::uint64_t local_completed = 0;
+                for( std::uint64_t segment = next_segment++; segment < segment_count; segment = next_segment++ ) {
+                    if( stop.stop_requested( ) ) break;
+                    const auto start = std::chrono::steady_clock::now( );
+                    const std::uint64_t segment_first_bit = std::max( first_bit, aligned_first_bit + segment * segment_bits );
+                    const std::uint64_t segment_last_bit  =
+                        std::min( aligned_first_bit + ( segment + 1 ) * segment_bits, last_bit );
+                    local_count += sieve_one( segment_first_bit, segment_last_bit, words );
+                    ++local_completed;
+                    if( progress != nullptr ) {
+                        // Each bit stands for two numbers (an odd one and the even one after it).
+                        progress->segment_done( index,
+                                                2 * ( segment_last_bit - segment_first_bit ),
+                                                std::chrono::steady_clock::now( ) - start );
+                    }
+                }
+                total += local_count;
+                completed += local_completed;
+            };
+
+            std::vector<std::thread> workers;
+            for( unsigned i = 1; i < worker_count; ++i ) {
+                workers.emplace_back( worker, i );
+            }
+            worker( 0 );
+            for( auto &thread : workers ) {
+                thread.join( );
+            }
+
+            if( completed != segment_count ) throw SieveCancelled( "Sieve stopped before it was finished" );
+            return total;
+        }
+    }
+
+
+    // SieveProgress
+    // =============
+
+    double SieveProgress::fraction_done( ) const
+    {
+        const std::uint64_t total_segments = get_total( );
+        if( total_segments == 0 ) return is_finished( ) ? 1.0 : 0.0;
+        return static_cast<double>( get_completed( ) ) / static_cast<double>( total_segments );
+    }
+
+
+    std::chrono::duration<double> SieveProgress::elapsed( ) const
+    {
+        const std::int64_t finished = finish_nanoseconds.load( std::memory_order_acquire );
+        if( finished != 0 ) return std::chrono::nanoseconds( finished );
+
+        std::lock_guard<std::mutex> lock( start_mutex );
+        if( counters == nullptr ) return std::chrono::duration<double>( 0.0 );
+        return std::chrono::steady_clock::now( ) - start_time;
+    }
+
+
+    std::chrono::duration<double> SieveProgress::estimated_remaining( ) const
+    {
+        // The rate is measured over the whole job so far, which smooths out the differences
+        // between segments (the first ones have more multiples of small primes to cross out).
+        const std::uint64_t done = get_completed( );
+        const std::uint64_t total_segments = get_total( );
+        if( done == 0 || done >= total_segments ) return std::chrono::duration<double>( 0.0 );
+        return elapsed( ) * ( static_cast<double>( total_segments - done ) / static_cast<double>( done ) );
+    }
+
+
+    std::vector<SieveProgress::ThreadReport> SieveProgress::thread_reports( ) const
+    {
+        std::lock_guard<std::mutex> lock( start_mutex );
+        std::vector<ThreadReport> reports( counter_count );
+        for( unsigned i = 0; i < counter_count; ++i ) {
+            reports[i].segments = counters[i].segments.load( std::memory_order_relaxed );
+            reports[i].numbers  = counters[i].numbers.load( std::memory_order_relaxed );
+            reports[i].seconds  = static_cast<double>( counters[i].nanoseconds.load( std::memory_order_relaxed ) ) / 1.0E9;
+        }
+        return reports;
+    }
+
+
+    void SieveProgress::start( std::uint64_t total_segments, unsigned thread_count )
+    {
+        std::lock_guard<std::mutex> lock( start_mutex );
+        counters = std::make_unique<ThreadCounters[]>( thread_count );
+        counter_count = thread_count;
+        start_time = std::chrono::steady_clock::now( );
+        completed.store( 0, std::memory_order_relaxed );
+        total.store( total_segments, std::memory_order_relaxed );
+
+        // No segment_done( ) call will finish an empty job, so it is finished now. The time is
+        // stored as one nanosecond because zero means "not finished."
+        finish_nanoseconds.store( total_segments == 0 ? 1 : 0, std::memory_order_release );
+    }
+
+
+    void SieveProgress::segment_done( unsigned thread, std::uint64_t numbers, std::chrono::steady_clock::duration time )
+    {
+        // The counters are only replaced by start( ), which isn't called while a job runs.
+        ThreadCounters &mine = counters[thread];
+        mine.segments.fetch_add( 1, std::memory_order_relaxed );
+        mine.numbers.fetch_add( numbers, std::memory_order_relaxed );
+        mine.nanoseconds.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( time ).count( ),
+                                    std::memory_order_relaxed );
+
+        // The thread that finishes the last segment records how long the job took.
+        if( completed.fetch_add( 1, std::memory_order_relaxed ) + 1 == get_total( ) ) {
+            const auto job_time = std::chrono::steady_clock::now( ) - start_time;
+            finish_nanoseconds.store(
+                std::max<std::int64_t>( 1, std::chrono::duration_cast<std::chrono::nanoseconds>( job_time ).count( ) ),
+                std::memory_order_release );
+        }
+    }
+
+
+    std::vector<std::uint32_t> small_odd_primes( std::uint32_t limit )
+    {
+        // A simple (unsegmented) sieve of the odd numbers is fast enough for small limits.
+        std::vector<std::uint32_t> result;
+        std::vector<bool> composite( limit / 2 + 1 );
+        for( std::uint64_t n = 3; n <= limit; n += 2 ) {
+            if( composite[n / 2] ) continue;
+            result.push_back( static_cast<std::uint32_t>( n ) );
+            for( std::uint64_t multiple = n * n; multiple <= limit; multiple += 2 * n ) {
+                composite[multiple / 2] = true;
+            }
+        }
+        return result;
+    }
+
+
+    PrimeSieve::PrimeSieve( std::uint64_t limit, unsigned thread_count ) :
+        limit( limit ), prime_count( 0 )
+    {
+        fill( thread_count, nullptr, std::stop_token( ) );
+    }
+
+
+    PrimeSieve::PrimeSieve( std::uint64_t limit, unsigned thread_count, SieveProgress &progress, std::stop_token stop ) :
+        limit( limit ), prime_count( 0 )
+    {
+        fill( thread_count, &progress, stop );
+    }
+
+
+    void PrimeSieve::fill( unsigned thread_count, SieveProgress *progress, std::stop_token stop )
+    {
+        // Bit i stands for 2 * i + 1, so bit_count bits cover the odd numbers up to limit.
+        const std::uint64_t bit_count = ( limit + 1 ) / 2;
+        bits.assign( ( bit_count + 63 ) / 64, ~std::uint64_t( 0 ) );
+
+        // Bits past the limit and the bit for 1 (which isn't prime) are cleared up front.
+        if( !bits.empty( ) ) {
+            if( bit_count % 64 != 0 ) bits.back( ) = ( std::uint64_t( 1 ) << ( bit_count % 64 ) ) - 1;
+            bits[0] &= ~std::uint64_t( 1 );
+        }
+
+        const std::vector<std::uint32_t> base_primes =
+            small_odd_primes( static_cast<std::uint32_t>( integer_sqrt( limit ) ) );
+
+        const std::uint64_t total = for_each_segment(
+            0, bit_count, thread_count, progress, stop,
+            [&]( std::uint64_t first_bit, std::uint64_t last_bit, std::vector<std::uint64_t> & ) {
+                sieve_segment( bits.data( ) + first_bit / 64, first_bit, last_bit, base_primes );
+
+                // Count the primes while the segment is still in the cache.
+                return count_bits( bits.data( ), first_bit, last_bit );
+            } );
+
+        // The table only holds odd numbers, so 2 is counted separately.
+        prime_count = total + ( limit >= 2 ? 1 : 0 );
+    }
+
+
+    std::uint64_t PrimeSieve::count( std::uint64_t low, std::uint64_t high ) const
+    {
+        high = std::min( high, limit );
+        if( low > high ) return 0;
+        const std::uint64_t two = ( low <= 2 && 2 <= high ) ? 1 : 0;
+        return two + count_bits( bits.data( ), bit_at_or_above( low ), bit_after( high ) );
+    }
+
+
+    // PrimeRange
+    // ==========
+
+    PrimeRange::PrimeRange( std::uint64_t low, std::uint64_t high ) :
+        low( low ),
+        high( checked_high( high, "PrimeRange::PrimeRange( )" ) ),
+        base_primes( small_odd_primes( static_cast<std::uint32_t>( integer_sqrt( high ) ) ) ),
+        segment_first_bit( 0 ),
+        next_bit( bit_at_or_above( low ) / 64 * 64 ),
+        word_index( 0 ),
+        current_word( 0 ),
+        current( 0 )
+    { }
+
+
+    PrimeRange::iterator PrimeRange::begin( )
+    {
+        // The first prime is found here, so that *begin( ) is valid right away.
+        if( current == 0 ) advance( );
+        return iterator( this );
+    }
+
+
+    void PrimeRange::advance( )
+    {
+        // The only even prime isn't in the table, so it is handled first.
+        if( current == 0 && low <= 2 && 2 <= high ) {
+            current = 2;
+            return;
+        }
+        const std::uint64_t window_last_bit = bit_after( high );
+        while( true ) {
+            if( current_word != 0 ) {
+                // The lowest set bit of the current word is the next prime.
+                const unsigned bit = static_cast<unsigned>( std::countr_zero( current_word ) );
+                current_word &= current_word - 1;
+                current = 2 * ( segment_first_bit + 64 * word_index + bit ) + 1;
+                return;
+            }
+            if( ++word_index < words.size( ) ) {
+                current_word = words[word_index];
+                continue;
+            }
+            if( next_bit >= window_last_bit || low > high ) {
+                current = done;
+                return;
+            }
+            segment_first_bit = next_bit;
+            next_bit = std::min( next_bit + segment_bits, window_last_bit );
+            sieve_window_segment( words, segment_first_bit, next_bit, bit_at_or_above( low ), window_last_bit, base_primes );
+            word_index = 0;
+            current_word = words[0];
+        }
+    }
+
+
+    namespace {
+
+        std::uint64_t count_primes_with( std::uint64_t low,
+                                         std::uint64_t high,
+                                         unsigned thread_count,
+                                         SieveProgress *progress,
+                                         std::stop_token stop )
+        {
+            checked_high( high, "count_primes( )" );
+            if( low > high ) {
+                if( progress != nullptr ) progress->start( 0, 1 );
+                return 0;
+            }
+            const std::vector<std::uint32_t> base_primes =
+                small_odd_primes( static_cast<std::uint32_t>( integer_sqrt( high ) ) );
+            const std::uint64_t window_first_bit = bit_at_or_above( low );
+            const std::uint64_t window_last_bit  = bit_after( high );
+
+            // Unlike the constructor of PrimeSieve, each thread sieves into its own buffer, which
+            // is reused for each of its segments. The segments are aligned to words, so the
+            // first one might start before the window.
+            const std::uint64_t total = for_each_segment(
+                window_first_bit, window_last_bit, thread_count, progress, stop,
+                [&]( std::uint64_t first_bit, std::uint64_t last_bit, std::vector<std::uint64_t> &words ) {
+                    const std::uint64_t aligned_first_bit = first_bit / 64 * 64;
+                    sieve_window_segment( words, aligned_first_bit, last_bit, window_first_bit, window_last_bit, base_primes );
+                    return count_bits( words.data( ), 0, last_bit - aligned_first_bit );
+                } );
+            return total + ( ( low <= 2 && 2 <= high ) ? 1 : 0 );
+        }
+    }
+
+
+    std::uint64_t count_primes( std::uint64_t low, std::uint64_t high, unsigned thread_count )
+    {
+        return count_primes_with( low, high, thread_count, nullptr, std::stop_token( ) );
+    }
+
+
+    std::uint64_t count_primes( std::uint64_t low,
+                                std::uint64_t high,
+                                unsigned thread_count,
+                                SieveProgress &progress,
+                                std::stop_token stop )
+    {
+        return count_primes_with( low, high, thread_count, &progress, stop );
+    }
+
+
+}
@@ -0,0 +1,259 @@
+/*! \file    PrimeSieve.hpp
+ *  \brief   Interface to a segmented, multithreaded Sieve of Eratosthenes.
+ *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ *
+ * The sieve stores one bit for each odd number (even numbers other than 2 are never prime),
+ * so the table for the numbers up to one billion takes about 60 MB instead of the 1 GB needed
+ * by an array of bool. The table is filled one segment at a time. Each segment is small enough
+ * to stay in the L1 cache while all the base primes cross it, which is much faster than
+ * crossing out the multiples of each prime over the whole table. Segments are independent, so
+ * they are handed out to several threads.
+ *
+ * Programs that don't need the whole table can use PrimeRange, which finds the primes in a
+ * window of numbers one segment at a time, or count_primes( ). Their memory use doesn't depend
+ * on the size of the window, so they can be used far beyond the limits of a PrimeSieve.
+ *
+ * Long running jobs can be watched and stopped from another thread. A SieveProgress object
+ * records how many segments are done (and how fast each thread is going), and a std::stop_token
+ * asks the workers to stop after their current segments. A job that is stopped early throws
+ * SieveCancelled instead of returning an incomplete result.
+ */
+
+#ifndef PRIMESIEVE_HPP
+#define PRIMESIEVE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vtsu {
+
+    //! Thrown when a sieve job is stopped (by its std::stop_token) before it is finished.
+    class SieveCancelled : public std::runtime_error {
+    public:
+        SieveCancelled( const std::string &message ) : std::runtime_error( message ) { }
+    };
+
+    //! The progress of a sieve job, safe to read from other threads while the job runs.
+    /*!
+     * A SieveProgress object can be used for one job at a time. Starting another job with the
+     * same object resets it.
+     */
+    class SieveProgress {
+    public:
+        //! The work done by one thread.
+        struct ThreadReport {
+            std::uint64_t segments = 0;  //!< The number of segments sieved.
+            std::uint64_t numbers  = 0;  //!< The number of integers covered by those segments.
+            double        seconds  = 0.0;  //!< The time spent sieving them.
+
+            double numbers_per_second( ) const
+                { return seconds > 0.0 ? static_cast<double>( numbers ) / seconds : 0.0; }
+        };
+
+        SieveProgress( ) = default;
+        SieveProgress( const SieveProgress & ) = delete;
+        SieveProgress &operator=( const SieveProgress & ) = delete;
+
+        //! Returns the number of segments sieved so far.
+        std::uint64_t get_completed( ) const
+            { return completed.load( std::memory_order_relaxed ); }
+
+        //! Returns the total number of segments in the job (zero before the job starts).
+        std::uint64_t get_total( ) const
+            { return total.load( std::memory_order_relaxed ); }
+
+        //! Returns true if every segment of the job has been sieved.
+        /*!
+         * A job with no segments (for example, counting the primes in an empty window) is
+         * finished as soon as it starts.
+         */
+        bool is_finished( ) const
+            { return finish_nanoseconds.load( std::memory_order_acquire ) != 0; }
+
+        //! Returns the fraction of the segments that have been sieved (0.0 .. 1.0).
+        double fraction_done( ) const;
+
+        //! Returns the time since the job started (or the time it took, if it is finished).
+        std::chrono::duration<double> elapsed( ) const;
+
+        //! Estimates the time until the job is finished, assuming the current rate continues.
+        std::chrono::duration<double> estimated_remaining( ) const;
+
+        //! Returns the work done so far by each thread of the job.
+        std::vector<ThreadReport> thread_reports( ) const;
+
+        // The sieve uses these methods to record its progress.
+        void start( std::uint64_t total_segments, unsigned thread_count );
+        void segment_done( unsigned thread, std::uint64_t numbers, std::chrono::steady_clock::duration time );
+
+    private:
+        struct ThreadCounters {
+            std::atomic<std::uint64_t> segments{ 0 };
+            std::atomic<std::uint64_t> numbers{ 0 };
+            std::atomic<std::int64_t>  nanoseconds{ 0 };
+        };
+
+        std::atomic<std::uint64_t> completed{ 0 };
+        std::atomic<std::uint64_t> total{ 0 };
+        std::atomic<std::int64_t>  finish_nanoseconds{ 0 };  // Job time once finished (never 0).
+
+        // The mutex protects the start time and the (replacement of the) counters, which only
+        // change when a job starts.
+        mutable std::mutex start_mutex;
+        std::chrono::steady_clock::time_point start_time;
+        std::unique_ptr<ThreadCounters[]> counters;
+        unsigned counter_count = 0;
+    };
+
+
+    //! A table of the primes up to some limit.
+    class PrimeSieve {
+    public:
+        //! The number of bytes of the table sieved at once by each thread (fits in L1 cache).
+        static const std::size_t segment_bytes = 32 * 1024;
+
+        //! Finds the primes less than or equal to `limit` using `thread_count` threads.
+        /*!
+         * A thread count of zero or one does all the work in the calling thread.
+         */
+        explicit PrimeSieve( std::uint64_t limit, unsigned thread_count = std::thread::hardware_concurrency( ) );
+
+        //! Finds the primes as above, recording the progress of the work in `progress`.
+        /*!
+         * \throws SieveCancelled if a stop is requested with `stop` before the table is done.
+         */
+        PrimeSieve( std::uint64_t limit, unsigned thread_count, SieveProgress &progress, std::stop_token stop = { } );
+
+        //! Returns the limit given to the constructor.
+        std::uint64_t get_limit( ) const
+            { return limit; }
+
+        //! Returns true if `n` is prime. The value of `n` must not be larger than the limit.
+        bool is_prime( std::uint64_t n ) const
+        {
+            if( n % 2 == 0 ) return n == 2;
+            return ( bits[n / 128] >> ( n / 2 % 64 ) ) & 1U;
+        }
+
+        //! Returns the number of primes less than or equal to the limit.
+        std::uint64_t count( ) const
+            { return prime_count; }
+
+        //! Returns the number of primes p with low <= p <= high (and p <= the limit).
+        /*!
+         * The table is counted a 64 bit word at a time with std::popcount.
+         */
+        std::uint64_t count( std::uint64_t low, std::uint64_t high ) const;
+
+    private:
+        std::uint64_t limit;
+        std::uint64_t prime_count;
+
+        void fill( unsigned thread_count, SieveProgress *progress, std::stop_token stop );
+
+        // Bit i of the table (bit i % 64 of bits[i / 64]) is set if 2 * i + 1 is prime.
+        std::vector<std::uint64_t> bits;
+    };
+
+    //! The primes in a window of numbers, found as they are needed.
+    /*!
+     * A PrimeRange is an input range: it can be traversed only once. It holds the odd primes
+     * up to the square root of `high` and one segment of the window (PrimeSieve::segment_bytes),
+     * so the size of the window doesn't matter. For example:
+     *
+     *     for( std::uint64_t p : vtsu::PrimeRange( 1'000'000'000'000, 1'000'000'001'000 ) ) ...
+     */
+    class PrimeRange {
+    public:
+        class iterator {
+        public:
+            using iterator_concept = std::input_iterator_tag;
+            using value_type       = std::uint64_t;
+            using difference_type  = std::ptrdiff_t;
+
+            iterator( ) = default;
+
+            std::uint64_t operator*( ) const
+                { return range->current; }
+
+            iterator &operator++( )
+                { range->advance( ); return *this; }
+
+            void operator++( int )
+                { range->advance( ); }
+
+            bool operator==( std::default_sentinel_t ) const
+                { return range->current == done; }
+
+        private:
+            friend class PrimeRange;
+            explicit iterator( PrimeRange *range ) : range( range ) { }
+            PrimeRange *range = nullptr;
+        };
+
+        //! Creates a range of the primes p with low <= p <= high.
+        /*!
+         * \throws std::out_of_range if high is 2**63 or more.
+         */
+        PrimeRange( std::uint64_t low, std::uint64_t high );
+
+        //! Returns an iterator at the first prime (or the end if there are none).
+        iterator begin( );
+
+        std::default_sentinel_t end( ) const
+            { return std::default_sentinel; }
+
+    private:
+        static const std::uint64_t done = ~std::uint64_t( 0 );  // Marks the end of the range.
+
+        std::uint64_t low;
+        std::uint64_t high;
+        std::vector<std::uint32_t> base_primes;
+        std::vector<std::uint64_t> words;   // The current segment.
+        std::uint64_t segment_first_bit;    // The bit (see PrimeSieve) of words[0].
+        std::uint64_t next_bit;             // The first bit of the next segment.
+        std::size_t   word_index;           // The word holding current.
+        std::uint64_t current_word;         // The bits of words[word_index] after current.
+        std::uint64_t current;              // The current prime (zero before the first one).
+
+        void advance( );                    // Moves to the next prime.
+    };
+
+    //! Returns the number of primes p with low <= p <= high, using `thread_count` threads.
+    /*!
+     * This sieves the window one segment at a time without keeping a table, so its memory use
+     * depends only on the number of threads and the square root of `high`.
+     *
+     * \throws std::out_of_range if high is 2**63 or more.
+     */
+    std::uint64_t count_primes( std::uint64_t low,
+                                std::uint64_t high,
+                                unsigned thread_count = std::thread::hardware_concurrency( ) );
+
+    //! Counts primes as above, recording the progress of the work in `progress`.
+    /*!
+     * \throws SieveCancelled if a stop is requested with `stop` before the count is done.
+     * \throws std::out_of_range if high is 2**63 or more.
+     */
+    std::uint64_t count_primes( std::uint64_t low,
+                                std::uint64_t high,
+                                unsigned thread_count,
+                                SieveProgress &progress,
+                                std::stop_token stop = { } );
+
+    //! Returns the odd primes up to and including `limit` (used as the base primes of a sieve).
+    std::vector<std::uint32_t> small_odd_primes( std::uint32_t limit );
+
+}
+
+#endif
@@ -1,57 +1,72 @@
 /*! \file    Sieve.cpp
  *  \brief   Sample program to demonstrate futures and promises.
  *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ *
+ * The sieve runs in the background (see PrimeSieve.hpp for how it works) while the main thread
+ * shows its progress. The limit, the number of threads used by the sieve, and a time limit (in
+ * seconds) can be given on the command line. If the time limit is reached the sieve is stopped.
+ * Afterwards the primes just past the end of the table are found with a PrimeRange, which
+ * doesn't need a table.
  */
 
 #include <chrono>
-#include <iostream>
-#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <future>
+#include <iomanip>
+#include <iostream>
+#include <stop_token>
+#include <thread>
+#include <vector>
 
-// Lock associated with shared resource (the boolean array). This is currently not used, but it
-// could be used to protect the array from concurrent access in a future version of this
-// program.
-std::mutex prime_mutex;
+#include "PrimeSieve.hpp"
 
-constexpr std::size_t ARRAY_SIZE = 1'000'000'000;
-bool prime_array[ARRAY_SIZE + 1];
+int main( int argc, char **argv )
+{
+    std::uint64_t limit = 1'000'000'000;
+    unsigned thread_count = std::thread::hardware_concurrency( );
+    if( argc > 1 ) limit = std::strtoull( argv[1], nullptr, 10 );
+    if( argc > 2 ) thread_count = static_cast<unsigned>( std::atoi( argv[2] ) );
+    double time_limit = 0.0;  // Zero means no limit.
+    if( argc > 3 ) time_limit = std::atof( argv[3] );
 
-// This implementation is a modified version of the Sieve of Eratosthenes algorithm found at
-// https://www.geeksforgeeks.org/sieve-of-eratosthenes/.
-void SieveOfEratosthenes( ) 
-{ 
-    for( std::size_t i = 0; i <= ARRAY_SIZE; ++i ) {
-        prime_array[i] = true;
+    vtsu::SieveProgress progress;
+    std::stop_source stop;
+    std::future<vtsu::PrimeSieve> sieve_future =
+        std::async( std::launch::async, [&] { return vtsu::PrimeSieve( limit, thread_count, progress, stop.get_token( ) ); } );
+    while( sieve_future.wait_for( std::chrono::milliseconds( 250 ) ) != std::future_status::ready ) {
+        std::cout << "\r" << std::fixed << std::setprecision( 1 )
+                  << std::setw( 5 ) << 100.0 * progress.fraction_done( ) << "% done, about "
+                  << progress.estimated_remaining( ).count( ) << " seconds left   " << std::flush;
+        if( time_limit > 0.0 && progress.elapsed( ).count( ) > time_limit ) stop.request_stop( );
     }
-  
-    for( std::size_t p = 2; p * p <= ARRAY_SIZE; p++ ) { 
-        // If prime[p] is not changed, then it is a prime. 
-        if( prime_array[p] ) { 
-            // Update all multiples of p greater than or equal to the square of it. Numbers
-            // which are multiple of p and are less than p^2 are already been marked. 
-            for( std::size_t i = p * p; i <= ARRAY_SIZE; i += p ) 
-                prime_array[i] = false; 
-        } 
-    } 
-}
+    std::cout << std::endl << std::defaultfloat << std::setprecision( 6 );
 
-std::size_t count_primes( )
-{
-    std::size_t prime_count = 0;
-    for( std::size_t i = 2; i <= ARRAY_SIZE; ++i ) {
-        if( prime_array[i] ) ++prime_count;
+    try {
+        const vtsu::PrimeSieve sieve = sieve_future.get( );
+        std::cout << "There are " << sieve.count( ) << " primes less than or equal to "
+                  << limit << std::endl;
+        std::cout << "(" << progress.elapsed( ).count( ) << " seconds using " << thread_count << " threads)" << std::endl;
+        std::cout << "There are " << sieve.count( limit / 2, limit ) << " primes in the upper half" << std::endl;
+    }
+    catch( const vtsu::SieveCancelled & ) {
+        std::cout << "Stopped after " << progress.get_completed( ) << " of " << progress.get_total( )
+                  << " segments" << std::endl;
     }
-    return prime_count;
-}
 
-int main( )
-{
-    std::future<void> sieve_future = std::async( std::launch::async, SieveOfEratosthenes );
-    while( sieve_future.wait_for( std::chrono::seconds( 1 ) ) != std::future_status::ready ) {
-        std::cout << "." << std::flush;
+    const std::vector<vtsu::SieveProgress::ThreadReport> reports = progress.thread_reports( );
+    for( std::size_t i = 0; i < reports.size( ); ++i ) {
+        std::cout << "  Thread " << i << ": " << reports[i].segments << " segments, "
+                  << reports[i].numbers_per_second( ) / 1.0E6 << " million numbers per second" << std::endl;
+    }
+
+    std::cout << "The next primes are:";
+    int printed = 0;
+    for( std::uint64_t p : vtsu::PrimeRange( limit + 1, 2 * limit + 100 ) ) {
+        std::cout << " " << p;
+        if( ++printed == 5 ) break;
     }
     std::cout << std::endl;
-    std::cout << "There are " << count_primes( ) << " primes less than or equal to "
-              << ARRAY_SIZE << std::endl;
-     return 0;
+    return 0;
 }
@@ -0,0 +1,182 @@
+/*! \file    ThreadPool.cpp
+ *  \brief   Implementation of a reusable work stealing thread pool.
+ *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+namespace vtsu {
+
+    ThreadPool::ThreadPool( unsigned thread_count )
+    {
+        // All the workers (and their deques) exist before any of them start stealing.
+        const unsigned worker_count = ( thread_count > 1 ) ? thread_count : 1;
+        for( unsigned i = 0; i < worker_count; ++i ) {
+            workers.push_back( std::make_unique<Worker>( ) );
+        }
+        for( std::size_t i = 0; i < workers.size( ); ++i ) {
+            workers[i]->thread = std::thread( &ThreadPool::worker_loop, this, i );
+        }
+    }
+
+
+    ThreadPool::~ThreadPool( )
+    {
+        {
+            std::lock_guard<std::mutex> guard( sleep_lock );
+            stopping = true;
+        }
+        wake.notify_all( );
+        for( auto &worker : workers ) {
+            worker->thread.join( );
+        }
+    }
+
+
+    void ThreadPool::push( Task *task, Priority priority )
+    {
+        const std::size_t level = static_cast<std::size_t>( priority );
+        if( is_worker( ) ) {
+            workers[current_index]->deques[level].push( task );
+        }
+        else {
+            SharedQueue &queue = shared_queues[level];
+            std::lock_guard<std::mutex> guard( queue.lock );
+            queue.tasks.push_back( task );
+            queue.count.fetch_add( 1, std::memory_order_relaxed );
+        }
+        pending.fetch_add( 1 );
+
+        // A worker increments `sleeping` before it checks `pending` for the last time, so if
+        // `sleeping` is zero here the worker will see this task. Otherwise taking the lock
+        // ensures that the worker is either still checking or is waiting for the notification.
+        // Skipping the lock when nobody sleeps keeps busy pools from contending for it.
+        if( sleeping.load( ) != 0 ) {
+            {
+                std::lock_guard<std::mutex> guard( sleep_lock );
+            }
+            wake.notify_one( );
+        }
+    }
+
+
+    ThreadPool::Task *ThreadPool::take( )
+    {
+        if( pending.load( ) == 0 ) return nullptr;
+
+        const bool        worker = is_worker( );
+        const std::size_t index  = worker ? current_index : 0;
+        Task *task = nullptr;
+
+        // Look for the most important task first. At each priority try our own deque, then the
+        // shared queue, and then steal from the other workers.
+        for( std::size_t level = 0; level < priority_count; ++level ) {
+            if( worker && workers[index]->deques[level].pop( task ) ) break;
+
+            SharedQueue &queue = shared_queues[level];
+            if( queue.count.load( std::memory_order_relaxed ) != 0 ) {
+                std::lock_guard<std::mutex> guard( queue.lock );
+                if( !queue.tasks.empty( ) ) {
+                    task = queue.tasks.front( );
+                    queue.tasks.pop_front( );
+                    queue.count.fetch_sub( 1, std::memory_order_relaxed );
+                    break;
+                }
+            }
+
+            for( std::size_t i = 0; i < workers.size( ); ++i ) {
+                const std::size_t victim = ( index + i ) % workers.size( );
+                if( worker && victim == index ) continue;
+                if( workers[victim]->deques[level].steal( task ) ) break;
+                task = nullptr;
+            }
+            if( task != nullptr ) break;
+        }
+
+        if( task != nullptr ) pending.fetch_sub( 1 );
+        return task;
+    }
+
+
+    void ThreadPool::work_on( Loop &loop )
+    {
+        for( std::size_t chunk = loop.next_chunk++; chunk < loop.chunk_count; chunk = loop.next_chunk++ ) {
+            try {
+                loop.do_chunk( &loop, chunk );
+            }
+            catch( ... ) {
+                std::lock_guard<std::mutex> guard( loop.error_lock );
+                if( !loop.error ) loop.error = std::current_exception( );
+
+                // Chunks that haven't started are skipped.
+                loop.next_chunk.store( loop.chunk_count );
+            }
+        }
+    }
+
+
+    void ThreadPool::run_loop( Loop &loop, std::size_t helper_count )
+    {
+        // Helpers that find no chunks left finish right away, so it doesn't matter if some of
+        // them start after the calling thread has done all the work.
+        std::vector<HelperTask> helpers( helper_count );
+        for( HelperTask &helper : helpers ) {
+            helper.loop = &loop;
+            helper.run  = []( Task *self ) {
+                Loop &loop = *static_cast<HelperTask *>( self )->loop;
+                work_on( loop );
+                loop.active_helpers.fetch_sub( 1, std::memory_order_release );
+            };
+            loop.active_helpers.fetch_add( 1, std::memory_order_relaxed );
+            try {
+                push( &helper, Priority::high );
+            }
+            catch( ... ) {
+                // If a queue can't grow, the threads already helping (and this one) do the work.
+                loop.active_helpers.fetch_sub( 1, std::memory_order_relaxed );
+                break;
+            }
+        }
+
+        work_on( loop );
+
+        // The helpers refer to this stack frame, so they must all finish before it goes away.
+        // Other tasks are run while waiting (possibly including our own helpers).
+        while( loop.active_helpers.load( std::memory_order_acquire ) != 0 ) {
+            if( Task *task = take( ) ) {
+                task->run( task );
+            }
+            else {
+                std::this_thread::yield( );
+            }
+        }
+        if( loop.error ) std::rethrow_exception( loop.error );
+    }
+
+
+    void ThreadPool::worker_loop( std::size_t index )
+    {
+        current_pool  = this;
+        current_index = index;
+        while( true ) {
+            if( Task *task = take( ) ) {
+                task->run( task );
+                continue;
+            }
+            std::unique_lock<std::mutex> guard( sleep_lock );
+            if( stopping && pending.load( ) == 0 ) return;
+            sleeping.fetch_add( 1 );
+            wake.wait( guard, [this] { return stopping || pending.load( ) > 0; } );
+            sleeping.fetch_sub( 1 );
+        }
+    }
+
+}
@@ -0,0 +1,393 @@
+/*! \file    ThreadPool.hpp
+ *  \brief   Interface to a reusable work stealing thread pool.
+ *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ *
+ * A ThreadPool keeps a fixed set of worker threads and runs tasks on them, so a program doesn't
+ * need to start new threads for each piece of parallel work. Tasks are submitted with submit( ),
+ * which returns a std::future for the task's result, or created by parallel_for( ) and
+ * parallel_reduce( ), which divide a range of indices among the threads.
+ *
+ * Each worker has its own deques of tasks (one for each priority). A task submitted by a worker
+ * goes on that worker's deque, and the worker takes its newest task first. A worker with no
+ * work "steals" the oldest task of another worker. The deques are Chase-Lev deques: the owner
+ * pushes and pops without locks and thieves only compete with each other (and with the owner
+ * for the last task) using a single compare-and-swap. Tasks submitted by threads outside the
+ * pool go on a shared queue for their priority.
+ *
+ * A worker always runs the most important task it can find: it looks for a high priority task
+ * in all of the queues before it looks for a normal priority task, and so forth. Priorities
+ * don't preempt running tasks.
+ */
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vtsu {
+
+    //! A deque that one thread (the owner) uses as a stack while other threads steal from it.
+    /*!
+     * This is the deque of Chase and Lev ("Dynamic Circular Work-Stealing Deque", 2005) with
+     * the memory orderings of Lê et al. ("Correct and Efficient Work-Stealing for Weak Memory
+     * Models", 2013). Only the owner may call push( ) and pop( ). Any thread may call steal( ).
+     * The element type must be trivially copyable (it is normally a pointer). The deque grows
+     * as needed; old buffers are kept until the deque is destroyed because a thief might still
+     * be reading one.
+     */
+    template<typename T>
+    class WorkStealingDeque {
+        static_assert( std::is_trivially_copyable_v<T>, "WorkStealingDeque elements must be trivially copyable" );
+
+    public:
+        explicit WorkStealingDeque( std::size_t initial_capacity = 256 );
+
+        WorkStealingDeque( const WorkStealingDeque & ) = delete;
+        WorkStealingDeque &operator=( const WorkStealingDeque & ) = delete;
+
+        //! Adds an item to the bottom of the deque (owner only).
+        void push( T item );
+
+        //! Removes the item at the bottom of the deque (owner only). Returns false if empty.
+        bool pop( T &item );
+
+        //! Removes the item at the top of the deque. Returns false if it is empty or if another
+        //! thread took the item first.
+        bool steal( T &item );
+
+        //! Returns true if the deque appears to be empty (it might change at any time).
+        bool empty( ) const
+            { return bottom.load( std::memory_order_relaxed ) <= top.load( std::memory_order_relaxed ); }
+
+    private:
+        struct Buffer {
+            std::int64_t capacity;  // A power of two.
+            std::unique_ptr<std::atomic<T>[]> slots;
+
+            explicit Buffer( std::int64_t capacity ) :
+                capacity( capacity ), slots( new std::atomic<T>[static_cast<std::size_t>( capacity )] ) { }
+
+            T get( std::int64_t index ) const
+                { return slots[index & ( capacity - 1 )].load( std::memory_order_relaxed ); }
+
+            void put( std::int64_t index, T item )
+                { slots[index & ( capacity - 1 )].store( item, std::memory_order_relaxed ); }
+        };
+
+        // The owner and the thieves write different indices, so they are kept on different cache
+        // lines.
+        alignas( 64 ) std::atomic<std::int64_t> top{ 0 };
+        alignas( 64 ) std::atomic<std::int64_t> bottom{ 0 };
+        alignas( 64 ) std::atomic<Buffer *> buffer;
+        std::vector<std::unique_ptr<Buffer>> buffers;  // All buffers ever used (owner only).
+
+        Buffer *grow( Buffer *old, std::int64_t top_index, std::int64_t bottom_index );
+    };
+
+
+    //! A fixed set of threads that run submitted tasks.
+    class ThreadPool {
+    public:
+        //! The priorities of tasks, most important first.
+        enum class Priority { high, normal, low };
+        static const std::size_t priority_count = 3;
+
+        //! Creates a pool with `thread_count` worker threads (at least one).
+        explicit ThreadPool( unsigned thread_count = std::thread::hardware_concurrency( ) );
+
+        //! Runs the tasks that have already been submitted and then stops the worker threads.
+        ~ThreadPool( );
+
+        ThreadPool( const ThreadPool & ) = delete;
+        ThreadPool &operator=( const ThreadPool & ) = delete;
+
+        //! Returns the number of worker threads.
+        unsigned size( ) const
+            { return static_cast<unsigned>( workers.size( ) ); }
+
+        //! Arranges for `function( )` to be run by a worker and returns a future for its result.
+        /*!
+         * An exception thrown by the function is stored in the future. A task shouldn't wait
+         * for the future of another task because that keeps its worker from running anything
+         * else (which can deadlock the pool). Use parallel_for( ) or parallel_reduce( ) in
+         * tasks instead; they run other tasks while they wait.
+         */
+        template<typename Function>
+        std::future<std::invoke_result_t<std::decay_t<Function> &>>
+            submit( Function &&function, Priority priority = Priority::normal );
+
+        //! Calls `body( i )` for each i in [first, last), in parallel, and waits for all calls.
+        /*!
+         * The range is divided into chunks of `grain` indices (zero chooses a size based on the
+         * number of threads). Each chunk is done by one thread, and the calling thread does
+         * chunks too. The chunks are given to helper tasks with high priority, so a loop that
+         * has started is finished before other queued tasks start. If a call of `body` throws,
+         * the remaining chunks are skipped and the exception is rethrown here.
+         */
+        template<typename Index, typename Body>
+        void parallel_for( Index first, Index last, Body &&body, std::size_t grain = 0 );
+
+        //! Returns combine( ... combine( combine( identity, map( first ) ), map( first + 1 ) ) ... ).
+        /*!
+         * The values are combined in parallel, as described for parallel_for( ), so `combine`
+         * must be associative. Each chunk is reduced separately (starting from `identity`) and
+         * then the chunk results are combined in order, so the result doesn't depend on the
+         * number of threads for a given grain. This makes floating point sums repeatable.
+         */
+        template<typename Index, typename T, typename Map, typename Combine>
+        T parallel_reduce( Index first, Index last, T identity, Map &&map, Combine &&combine, std::size_t grain = 0 );
+
+    private:
+        // A Task is a function waiting to be run. Tasks created by submit( ) are allocated on the
+        // heap and delete themselves after running. The helper tasks of parallel_for( ) live in
+        // the stack frame of the call that created them, which doesn't return until they finish.
+        // The run function must not throw.
+        struct Task {
+            void ( *run )( Task * );
+        };
+
+        template<typename Function>
+        struct HeapTask : Task {
+            Function function;
+
+            explicit HeapTask( Function &&f ) : function( std::move( f ) )
+            {
+                this->run = []( Task *self ) {
+                    std::unique_ptr<HeapTask> owner( static_cast<HeapTask *>( self ) );
+                    owner->function( );
+                };
+            }
+        };
+
+        // The work of one parallel_for( ). Chunks are handed out by an atomic counter.
+        struct Loop {
+            std::size_t               chunk_count;
+            void                   ( *do_chunk )( Loop *, std::size_t );
+            std::atomic<std::size_t>  next_chunk{ 0 };
+            std::atomic<std::size_t>  active_helpers{ 0 };
+            std::mutex                error_lock;
+            std::exception_ptr        error;
+        };
+
+        struct HelperTask : Task {
+            Loop *loop;
+        };
+
+        template<typename ChunkFunction>
+        struct FunctionLoop : Loop {
+            ChunkFunction &chunk_function;
+
+            FunctionLoop( std::size_t count, ChunkFunction &f ) : chunk_function( f )
+            {
+                this->chunk_count = count;
+                this->do_chunk = []( Loop *self, std::size_t chunk )
+                    { static_cast<FunctionLoop *>( self )->chunk_function( chunk ); };
+            }
+        };
+
+        struct SharedQueue {
+            std::mutex               lock;
+            std::deque<Task *>       tasks;
+            std::atomic<std::size_t> count{ 0 };  // Lets take( ) skip empty queues without locking.
+        };
+
+        struct Worker {
+            std::array<WorkStealingDeque<Task *>, priority_count> deques;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>>    workers;
+        std::array<SharedQueue, priority_count> shared_queues;  // For threads outside the pool.
+        std::atomic<std::size_t>                pending{ 0 };   // Number of tasks in all queues.
+        std::atomic<unsigned>                   sleeping{ 0 };  // Number of waiting workers.
+        std::mutex                              sleep_lock;
+        std::condition_variable                 wake;
+        bool                                    stopping = false;
+
+        // The pool (if any) in which the current thread is a worker, and its index.
+        inline static thread_local const ThreadPool *current_pool  = nullptr;
+        inline static thread_local std::size_t       current_index = 0;
+
+        bool is_worker( ) const
+            { return current_pool == this; }
+
+        void  push( Task *task, Priority priority );
+        Task *take( );
+        void  run_loop( Loop &loop, std::size_t helper_count );
+        static void work_on( Loop &loop );
+        void  worker_loop( std::size_t index );
+
+        // Returns the number of indices in each chunk of a loop over `count` indices.
+        std::size_t chunk_size( std::size_t count, std::size_t grain ) const
+            { return grain != 0 ? grain : std::max<std::size_t>( 1, count / ( 8 * ( size( ) + 1 ) ) ); }
+    };
+
+
+    // WorkStealingDeque
+    // =================
+
+    template<typename T>
+    WorkStealingDeque<T>::WorkStealingDeque( std::size_t initial_capacity )
+    {
+        std::int64_t capacity = 1;
+        while( capacity < static_cast<std::int64_t>( initial_capacity ) ) capacity *= 2;
+        buffers.push_back( std::make_unique<Buffer>( capacity ) );
+        buffer.store( buffers.back( ).get( ), std::memory_order_relaxed );
+    }
+
+
+    template<typename T>
+    void WorkStealingDeque<T>::push( T item )
+    {
+        const std::int64_t b = bottom.load( std::memory_order_relaxed );
+        const std::int64_t t = top.load( std::memory_order_acquire );
+        Buffer *current = buffer.load( std::memory_order_relaxed );
+        if( b - t > current->capacity - 1 ) current = grow( current, t, b );
+        current->put( b, item );
+        std::atomic_thread_fence( std::memory_order_release );
+        bottom.store( b + 1, std::memory_order_relaxed );
+    }
+
+
+    template<typename T>
+    bool WorkStealingDeque<T>::pop( T &item )
+    {
+        const std::int64_t b = bottom.load( std::memory_order_relaxed ) - 1;
+        Buffer *current = buffer.load( std::memory_order_relaxed );
+        bottom.store( b, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        std::int64_t t = top.load( std::memory_order_relaxed );
+        if( t > b ) {
+            // The deque was empty.
+            bottom.store( b + 1, std::memory_order_relaxed );
+            return false;
+        }
+        item = current->get( b );
+        if( t == b ) {
+            // This is the last item, so a thief might be trying to take it too.
+            const bool won = top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+            bottom.store( b + 1, std::memory_order_relaxed );
+            return won;
+        }
+        return true;
+    }
+
+
+    template<typename T>
+    bool WorkStealingDeque<T>::steal( T &item )
+    {
+        std::int64_t t = top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        const std::int64_t b = bottom.load( std::memory_order_acquire );
+        if( t >= b ) return false;
+        item = buffer.load( std::memory_order_acquire )->get( t );
+        return top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+    }
+
+
+    template<typename T>
+    typename WorkStealingDeque<T>::Buffer *
+        WorkStealingDeque<T>::grow( Buffer *old, std::int64_t top_index, std::int64_t bottom_index )
+    {
+        buffers.push_back( std::make_unique<Buffer>( 2 * old->capacity ) );
+        Buffer *larger = buffers.back( ).get( );
+        for( std::int64_t i = top_index; i < bottom_index; ++i ) {
+            larger->put( i, old->get( i ) );
+        }
+        buffer.store( larger, std::memory_order_release );
+        return larger;
+    }
+
+
+    // ThreadPool
+    // ==========
+
+    template<typename Function>
+    std::future<std::invoke_result_t<std::decay_t<Function> &>>
+        ThreadPool::submit( Function &&function, Priority priority )
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function> &>;
+        using Packaged = std::packaged_task<Result( )>;
+
+        auto task = std::make_unique<HeapTask<Packaged>>( Packaged( std::forward<Function>( function ) ) );
+        std::future<Result> result = task->function.get_future( );
+        push( task.get( ), priority );
+        task.release( );
+        return result;
+    }
+
+
+    template<typename Index, typename Body>
+    void ThreadPool::parallel_for( Index first, Index last, Body &&body, std::size_t grain )
+    {
+        static_assert( std::is_integral_v<Index>, "parallel_for needs an integral index type" );
+        if( !( first < last ) ) return;
+
+        const std::size_t count = static_cast<std::size_t>( last - first );
+        const std::size_t chunk = chunk_size( count, grain );
+        auto chunk_function = [&]( std::size_t index ) {
+            const std::size_t begin = index * chunk;
+            const std::size_t end   = std::min( begin + chunk, count );
+            for( std::size_t offset = begin; offset < end; ++offset ) {
+                body( static_cast<Index>( first + static_cast<Index>( offset ) ) );
+            }
+        };
+
+        FunctionLoop<decltype( chunk_function )> loop( ( count + chunk - 1 ) / chunk, chunk_function );
+        run_loop( loop, std::min<std::size_t>( size( ), loop.chunk_count - 1 ) );
+    }
+
+
+    template<typename Index, typename T, typename Map, typename Combine>
+    T ThreadPool::parallel_reduce( Index first, Index last, T identity, Map &&map, Combine &&combine, std::size_t grain )
+    {
+        static_assert( std::is_integral_v<Index>, "parallel_reduce needs an integral index type" );
+        if( !( first < last ) ) return identity;
+
+        // The results are wrapped so that a T of bool doesn't become a std::vector<bool>, whose
+        // elements can't be written by different threads at once.
+        struct Partial {
+            T value;
+        };
+
+        const std::size_t count = static_cast<std::size_t>( last - first );
+        const std::size_t chunk = chunk_size( count, grain );
+        const std::size_t chunk_count = ( count + chunk - 1 ) / chunk;
+        std::vector<Partial> partials( chunk_count, Partial{ identity } );
+        auto chunk_function = [&]( std::size_t index ) {
+            const std::size_t begin = index * chunk;
+            const std::size_t end   = std::min( begin + chunk, count );
+            T local = identity;
+            for( std::size_t offset = begin; offset < end; ++offset ) {
+                local = combine( std::move( local ), map( static_cast<Index>( first + static_cast<Index>( offset ) ) ) );
+            }
+            partials[index].value = std::move( local );
+        };
+
+        FunctionLoop<decltype( chunk_function )> loop( chunk_count, chunk_function );
+        run_loop( loop, std::min<std::size_t>( size( ), chunk_count - 1 ) );
+
+        T result = std::move( identity );
+        for( Partial &partial : partials ) {
+            result = combine( std::move( result ), std::move( partial.value ) );
+        }
+        return result;
+    }
+
+}
+
+#endif
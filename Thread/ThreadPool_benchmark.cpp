@@ -0,0 +1,192 @@
+/*! \file    ThreadPool_benchmark.cpp
+ *  \brief   A program that compares ThreadPool with std::async.
+ *  \author  Peter Chapin <pchapin@vermontstate.edu>
+ *
+ * The first test measures the overhead of creating small tasks: each task adds up a few hundred
+ * numbers, which takes much less time than starting a thread. The tasks are run with
+ * std::async (which starts a thread for each task in the usual implementations) and with
+ * ThreadPool::submit( ). The time per task is shown for each, along with the time to do the
+ * same work in a plain loop. At most `batch_size` tasks are outstanding at once, because a
+ * system can only have so many threads; the futures of each batch are collected before the
+ * next batch is started.
+ *
+ * The other tests compare parallel_for( ) and parallel_reduce( ) with sequential loops, and
+ * show the order in which tasks of different priorities are run. The number of small tasks and
+ * the number of threads can be given on the command line. Build with optimization for
+ * meaningful results.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+namespace {
+
+    const std::size_t batch_size = 1000;
+
+    // The work done by one small task. The result depends on `seed` so the work can't be
+    // hoisted out of the loops that run it.
+    std::uint64_t small_task( std::uint64_t seed )
+    {
+        std::uint64_t sum = 0;
+        for( std::uint64_t i = 0; i < 256; ++i ) {
+            sum += ( seed + i ) * ( seed ^ i );
+        }
+        return sum;
+    }
+
+    // Returns the time taken by `function( )` in seconds.
+    template<typename Function>
+    double time_of( Function &&function )
+    {
+        const auto start = std::chrono::steady_clock::now( );
+        function( );
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now( ) - start;
+        return elapsed.count( );
+    }
+
+    // Writes the name of a measurement and its time. The names are padded so that the times
+    // line up.
+    void report( const std::string &name, double seconds )
+    {
+        std::cout << "  " << std::left << std::setw( 15 ) << name << std::right << ": " << seconds << " s";
+    }
+
+    void report( const std::string &name, double seconds, std::size_t count, std::uint64_t check )
+    {
+        report( name, seconds );
+        std::cout << " (" << 1.0E6 * seconds / static_cast<double>( count ) << " us each, check = "
+                  << check << ")" << std::endl;
+    }
+
+}
+
+
+int main( int argc, char **argv )
+{
+    std::size_t task_count = 100'000;
+    unsigned thread_count = std::thread::hardware_concurrency( );
+    if( argc > 1 ) task_count = std::strtoull( argv[1], nullptr, 10 );
+    if( argc > 2 ) thread_count = static_cast<unsigned>( std::atoi( argv[2] ) );
+
+    vtsu::ThreadPool pool( thread_count );
+    std::cout << "Using a pool of " << pool.size( ) << " threads" << std::endl;
+
+    // Small tasks
+    // -----------
+    std::cout << "\n" << task_count << " small tasks:" << std::endl;
+    std::uint64_t check = 0;
+
+    double seconds = time_of( [&] {
+        for( std::size_t i = 0; i < task_count; ++i ) check += small_task( i );
+    } );
+    report( "Loop", seconds, task_count, check );
+
+    check = 0;
+    seconds = time_of( [&] {
+        std::vector<std::future<std::uint64_t>> results;
+        for( std::size_t first = 0; first < task_count; first += batch_size ) {
+            for( std::size_t i = first; i < std::min( first + batch_size, task_count ); ++i ) {
+                results.push_back( std::async( std::launch::async, small_task, i ) );
+            }
+            for( auto &result : results ) check += result.get( );
+            results.clear( );
+        }
+    } );
+    report( "std::async", seconds, task_count, check );
+
+    check = 0;
+    seconds = time_of( [&] {
+        std::vector<std::future<std::uint64_t>> results;
+        for( std::size_t first = 0; first < task_count; first += batch_size ) {
+            for( std::size_t i = first; i < std::min( first + batch_size, task_count ); ++i ) {
+                results.push_back( pool.submit( [i] { return small_task( i ); } ) );
+            }
+            for( auto &result : results ) check += result.get( );
+            results.clear( );
+        }
+    } );
+    report( "submit", seconds, task_count, check );
+
+    check = 0;
+    seconds = time_of( [&] {
+        check = pool.parallel_reduce( std::size_t( 0 ), task_count, std::uint64_t( 0 ), small_task,
+                                      []( std::uint64_t x, std::uint64_t y ) { return x + y; } );
+    } );
+    report( "parallel_reduce", seconds, task_count, check );
+
+    // Loops
+    // -----
+    const std::size_t size = 20'000'000;
+    std::vector<double> values( size );
+    std::cout << "\nSquare roots of " << size << " numbers:" << std::endl;
+
+    seconds = time_of( [&] {
+        for( std::size_t i = 0; i < size; ++i ) values[i] = std::sqrt( static_cast<double>( i ) );
+    } );
+    report( "Loop", seconds );
+    std::cout << std::endl;
+
+    seconds = time_of( [&] {
+        pool.parallel_for( std::size_t( 0 ), size, [&]( std::size_t i ) { values[i] = std::sqrt( static_cast<double>( i ) ); } );
+    } );
+    report( "parallel_for", seconds );
+    std::cout << std::endl;
+
+    double total = 0.0;
+    seconds = time_of( [&] { total = std::accumulate( values.begin( ), values.end( ), 0.0 ); } );
+    report( "accumulate", seconds );
+    std::cout << " (sum = " << total << ")" << std::endl;
+
+    seconds = time_of( [&] {
+        total = pool.parallel_reduce( std::size_t( 0 ), size, 0.0, [&]( std::size_t i ) { return values[i]; },
+                                      []( double x, double y ) { return x + y; } );
+    } );
+    report( "parallel_reduce", seconds );
+    std::cout << " (sum = " << total << ")" << std::endl;
+
+    // Priorities
+    // ----------
+    // The only worker of this pool is kept busy until all the tasks are submitted, so they are
+    // run in order of priority (and in the order submitted for each priority).
+    std::cout << "\nTasks run in the order:";
+    {
+        vtsu::ThreadPool single( 1 );
+        std::promise<void> go;
+        std::shared_future<void> ready = go.get_future( ).share( );
+        std::mutex order_lock;
+        std::string order;
+        single.submit( [ready] { ready.wait( ); } );
+
+        const char *names[] = { "high", "normal", "low" };
+        const vtsu::ThreadPool::Priority priorities[] =
+            { vtsu::ThreadPool::Priority::low, vtsu::ThreadPool::Priority::high, vtsu::ThreadPool::Priority::normal,
+              vtsu::ThreadPool::Priority::high, vtsu::ThreadPool::Priority::low };
+        std::vector<std::future<void>> done;
+        int number = 0;
+        for( vtsu::ThreadPool::Priority priority : priorities ) {
+            const std::string label = " " + std::string( names[static_cast<int>( priority )] ) + "#" + std::to_string( ++number );
+            done.push_back( single.submit( [&, label] {
+                std::lock_guard<std::mutex> guard( order_lock );
+                order += label;
+            }, priority ) );
+        }
+        go.set_value( );
+        for( auto &task : done ) task.get( );
+        std::cout << order << std::endl;
+    }
+    return 0;
+}
@@ -3,35 +3,60 @@
  *  \author  Peter Chapin <peter.chapin@vermontstate.edu>
  */
 
+#include <charconv>
+#include <cstddef>
 #include <ctime>
-#include <iomanip>
 #include <iostream>
-#include <regex>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Time.hpp"
+#include "../Date/DigitChars.hpp"
 
 using namespace std;
 
 namespace vtsu {
 
+    namespace {
+
+        // Writes exactly time_chars characters to `text`. There must be room for them.
+        inline void write_time( char *text, unsigned seconds_of_day )
+        {
+            digits::write_pair( text, seconds_of_day / 3600U );
+            text[2] = ':';
+            digits::write_pair( text + 3, seconds_of_day / 60U % 60U );
+            text[5] = ':';
+            digits::write_pair( text + 6, seconds_of_day % 60U );
+        }
+
+        // Converts the digits at the start of `text` into an integer modulo `modulus`, reducing
+        // as it goes so that any number of digits can be handled. Returns a pointer to the first
+        // character that isn't a digit. If there are no digits, returns `text`.
+        const char *parse_component( const char *text, const char *end, unsigned modulus, unsigned &value )
+        {
+            unsigned result = 0;
+            for( ; text != end; ++text ) {
+                const unsigned digit = static_cast<unsigned char>( *text ) - '0';
+                if( digit > 9 ) break;
+                result = ( 10U * result + digit ) % modulus;
+            }
+            value = result;
+            return text;
+        }
+    }
+
     // Private Methods
     // ===============
 
     void Time::set( unsigned hours, unsigned minutes, unsigned seconds )
     {
-        // Compute the total number of seconds in the incoming time. The type unsigned long is
-        // used here for portability to 16 bit platforms.
-        unsigned long total = hours * 3600UL + minutes * 60UL + seconds;
-
-        this->seconds = total % 60UL;
-        total = total / 60UL;
-
-        this->minutes = total % 60UL;
-        total = total / 60UL;
-
-        this->hours   = total % 24UL;
+        // Reduce each component separately so that the total can't overflow. Only the hours
+        // modulo 24 and the minutes modulo 1440 matter.
+        seconds_of_day =
+            ( hours % 24U * 3600U + minutes % 1440U * 60U + seconds % seconds_per_day ) % seconds_per_day;
     }
 
 
@@ -40,9 +65,7 @@ namespace vtsu {
 
     Time::Time( )
     {
-        hours   = 0;
-        minutes = 0;
-        seconds = 0;
+        seconds_of_day = 0;
     }
 
 
@@ -52,66 +75,75 @@ namespace vtsu {
     }
 
 
-    Time::Time( const string &time_string )
+    Time::Time( string_view time_string )
     {
-        // The regular expression below matches a string of the form HH:MM:DD except that the
-        // components of the time are arbitrary unsigned integers.
-        regex  date_matcher{ R"((\d+):(\d+):(\d+))" };
-        smatch matches;
-
-        // Try to match the entire string. If the match fails, set the Time object to 00:00:00.
-        if( !regex_match( time_string, matches, date_matcher ) ) {
-            hours = minutes = seconds = 0U;
-            return;
-        }
+        // If the string can't be parsed, set the Time object to 00:00:00.
+        seconds_of_day = 0;
+        parse( time_string, seconds_of_day );
+    }
 
-        // The first alternative matched. Extract the sub-matches.
-        int incoming_hours   = stoi( matches[1] );  // Note: no range checking here!
-        int incoming_minutes = stoi( matches[2] );
-        int incoming_seconds = stoi( matches[3] );
 
-        // Delegate to Time::set( unsigned, unsigned, unsigned ) the task of wrapping values and
-        // installing the time into the object. Notice the type mismatch going from integers to
-        // unsigned integers. This is relatively okay since the matched integers are guaranteed
-        // to be positive. However, we sacrifice the ability to use a time string with extremely
-        // large time components (e.g., "4000000000:0:0").
-        set( incoming_hours, incoming_minutes, incoming_seconds );
-        return;
+    // Time strings have the form H:M:S where each component is one or more decimal digits, the
+    // strings matched by the regular expression (\d+):(\d+):(\d+) used in earlier versions.
+    // Since a component can have any number of digits, it can't be converted to an integer and
+    // then reduced (it might not fit). Instead each component is reduced as its digits are read,
+    // modulo the only range that affects the result: the hours modulo 24, the minutes modulo
+    // 1440 (the minutes in a day), and the seconds modulo the seconds in a day. For example,
+    // "25:61:3661" is 03:02:01.
+    bool Time::parse( string_view time_string, unsigned &seconds_of_day ) noexcept
+    {
+        const char *p = time_string.data( );
+        const char *const end = p + time_string.size( );
+        unsigned hours;
+        unsigned minutes;
+        unsigned seconds;
+
+        const char *next = parse_component( p, end, 24U, hours );
+        if( next == p || next == end || *next != ':' ) return false;
+        p = next + 1;
+        next = parse_component( p, end, 1440U, minutes );
+        if( next == p || next == end || *next != ':' ) return false;
+        p = next + 1;
+        next = parse_component( p, end, seconds_per_day, seconds );
+        if( next == p || next != end ) return false;
+
+        seconds_of_day = ( hours * 3600U + minutes * 60U + seconds ) % seconds_per_day;
+        return true;
     }
 
 
     unsigned Time::get_hours( ) const
     {
-        return hours;
+        return seconds_of_day / 3600U;
     }
 
 
     unsigned Time::get_minutes( ) const
     {
-        return minutes;
+        return seconds_of_day / 60U % 60U;
     }
 
 
     unsigned Time::get_seconds( ) const
     {
-        return seconds;
+        return seconds_of_day % 60U;
     }
 
     Time Time::roll_forward_seconds( unsigned delta ) const
     {
-        return Time( hours, minutes, seconds + delta );
+        return Time( 0U, 0U, seconds_of_day + delta % seconds_per_day );
     }
 
 
     Time Time::roll_forward_minutes( unsigned delta ) const
     {
-        return Time( hours, minutes + delta, seconds );
+        return Time( 0U, delta % 1440U, seconds_of_day );
     }
 
 
     Time Time::roll_forward_hours( unsigned delta ) const
     {
-        return Time( hours + delta, minutes, seconds );
+        return Time( delta % 24U, 0U, seconds_of_day );
     }
 
 
@@ -120,21 +152,46 @@ namespace vtsu {
 
     int operator-( const Time &future, const Time &past )
     {
-        unsigned long future_seconds =
-            future.get_hours( ) * 3600UL +
-            future.get_minutes( ) * 60UL +
-            future.get_seconds( );
-        unsigned long past_seconds =
-            past.get_hours( ) * 3600UL +
-            past.get_minutes( ) * 60UL +
-            past.get_seconds( );
-
         // It is important to cast before subtracting so that negative results don't invoke UB.
         // These casts aren't portable to 16 bit platforms, but then again, neither is the
         // return type of this function! The maximum possible difference between two times is
         // 86,399 seconds, which can't be represented by 16 bit integers.
         // TODO: Make this function portable to 16 bit platforms.
-        return static_cast<int>( future_seconds ) - static_cast<int>( past_seconds );
+        return static_cast<int>( future.get_seconds_of_day( ) ) - static_cast<int>( past.get_seconds_of_day( ) );
+    }
+
+
+    to_chars_result to_chars( char *first, char *last, const Time &the_time ) noexcept
+    {
+        if( last - first < static_cast<ptrdiff_t>( time_chars ) ) return { last, errc::value_too_large };
+        write_time( first, the_time.get_seconds_of_day( ) );
+        return { first + time_chars, errc{ } };
+    }
+
+
+    size_t parse_times( span<const string_view> time_strings, vector<Time> &times )
+    {
+        size_t failures = 0;
+        times.reserve( times.size( ) + time_strings.size( ) );
+        for( string_view time_string : time_strings ) {
+            unsigned seconds_of_day = 0;
+            if( !Time::parse( time_string, seconds_of_day ) ) ++failures;
+            times.emplace_back( 0U, 0U, seconds_of_day );
+        }
+        return failures;
+    }
+
+
+    void format_times( span<const Time> times, string &text, char separator )
+    {
+        const size_t original_size = text.size( );
+        text.resize( original_size + times.size( ) * ( time_chars + 1 ) );
+        char *p = text.data( ) + original_size;
+        for( const Time &the_time : times ) {
+            write_time( p, the_time.get_seconds_of_day( ) );
+            p[time_chars] = separator;
+            p += time_chars + 1;
+        }
     }
 
 
@@ -151,7 +208,7 @@ namespace vtsu {
         // field.
         auto print_fill = []( ostream &output, char fill, int width ) -> void {
             for( int i = 8; i < width; ++i ) {
-                output << fill;
+                output.put( fill );
             }
         };
 
@@ -167,12 +224,10 @@ namespace vtsu {
             print_fill( output, original_fill, original_width );
         }
 
-        // Print the actual Date3 object.
-        output << setfill( '0' );
-        output << setw( 2 ) << the_time.get_hours( )   << ':';
-        output << setw( 2 ) << the_time.get_minutes( ) << ':';
-        output << setw( 2 ) << the_time.get_seconds( );
-        output << setfill( original_fill );
+        // Print the actual Date3 object, formatted into a buffer and written all at once.
+        char buffer[time_chars];
+        write_time( buffer, the_time.get_seconds_of_day( ) );
+        output.write( buffer, time_chars );
 
         // If we are not trying to right justify (meaning we are being explicitly asked to left
         // justify OR no specific justification is requested), print the caller's fill character
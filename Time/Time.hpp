@@ -9,10 +9,15 @@
 #ifndef TIME_HPP
 #define TIME_HPP
 
+#include <charconv>
 #include <compare>     // Needed for spaceship operator.
+#include <cstddef>
 #include <iosfwd>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace vtsu {
 
@@ -35,6 +40,10 @@ namespace vtsu {
      * desired value. One consequence of this is that there is no operator>>( ) for Time
      * objects. Clients must accept times from the user as strings and then use the appropriate
      * constructor to convert those strings into Time objects.
+     *
+     * Internally a Time is the number of seconds since midnight. Rolling a Time forward and
+     * subtracting Times take constant time; the hours, minutes, and seconds are only computed
+     * when they are asked for.
      */
     class Time {
     public:
@@ -65,12 +74,13 @@ namespace vtsu {
          * minutes, and ss is the seconds. However, each component can be an arbitrary
          * (unsigned) integer. For example, "0:1:500" is a time string that represents 00:09:20.
          * If an invalid time string is given (i.e., one that has the wrong format), the time is
-         * set to 00:00:00.
+         * set to 00:00:00. The components may have any number of digits; they wrap around
+         * correctly even if they are too large for an unsigned int.
          * 
          * Implementation Hint: Create a private helper method that deals with the wrap-around
          * and sets the data members directly. Then call that method from both constructors.
          */
-        explicit Time( const std::string &time_string );
+        explicit Time( std::string_view time_string );
 
         /*
          * This declaration prevents the compiler from generating the copy assignment operator.
@@ -93,6 +103,10 @@ namespace vtsu {
         //! Returns the seconds of this Time (always in the range 0 .. 59).
         unsigned get_seconds( ) const;
 
+        //! Returns the number of seconds from midnight to this Time (in the range 0 .. 86,399).
+        unsigned get_seconds_of_day( ) const
+            { return seconds_of_day; }
+
         //! Advance the time by a given number of seconds.
         /*!
          * This method computes a new time by advancing this Time by the specified number of
@@ -139,8 +153,18 @@ namespace vtsu {
         // generate it automatically.
         auto operator<=>( const Time &other ) const = default;
 
+        //! The number of seconds in a day.
+        static const unsigned seconds_per_day = 86'400U;
+
+        //! Checks a time string and computes the time it represents.
+        /*!
+         * This is the parser used by the constructor taking a string. It returns false, and
+         * leaves `seconds_of_day` unchanged, if the string has the wrong format.
+         */
+        static bool parse( std::string_view time_string, unsigned &seconds_of_day ) noexcept;
+
     private:
-        unsigned hours, minutes, seconds;
+        unsigned seconds_of_day;  // Always less than seconds_per_day.
 
         // A private method to handle the wrap-around semantics is used by both constructors.
         void set( unsigned hours, unsigned minutes, unsigned seconds );
@@ -165,6 +189,36 @@ namespace vtsu {
      */
     int operator-( const Time &future, const Time &past );
 
+    //! The number of characters written by to_chars( ) for a Time.
+    constexpr std::size_t time_chars = 8;
+
+    //! Writes a Time in the form hh:mm:ss into [first, last).
+    /*!
+     * This is like std::to_chars: it doesn't allocate memory, throw exceptions, or depend on
+     * the locale. No null character is written.
+     *
+     * \return On success, `ptr` points after the last character written and `ec` is zero. If
+     * there are fewer than time_chars characters available, `ptr` is `last` and `ec` is
+     * std::errc::value_too_large.
+     */
+    std::to_chars_result to_chars( char *first, char *last, const Time &the_time ) noexcept;
+
+    //! Parses many time strings at once, as for a column of log timestamps.
+    /*!
+     * One Time is appended to `times` for each element of `time_strings`. Strings that can't
+     * be parsed give 00:00:00, as with the constructor taking a string.
+     *
+     * \return The number of strings that could not be parsed.
+     */
+    std::size_t parse_times( std::span<const std::string_view> time_strings, std::vector<Time> &times );
+
+    //! Appends many Times to a string.
+    /*!
+     * Each Time is written in the form hh:mm:ss and followed by `separator`. The string is
+     * enlarged once, so all the text is written into one contiguous buffer.
+     */
+    void format_times( std::span<const Time> times, std::string &text, char separator = '\n' );
+
     //! Writes a Time to an output stream.
     /*!
      * This function does not need to handle the fill character, width specifier, or
@@ -12,6 +12,8 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "Time.hpp"
 
 using namespace std;
@@ -270,6 +272,87 @@ void test5( )
 }
 
 
+void test6( )
+{
+    struct TestCase {
+        string   text;
+        bool     expected_valid;
+        unsigned expected_hours;
+        unsigned expected_minutes;
+        unsigned expected_seconds;
+    };
+
+    TestCase test_cases[] = {
+        { "12:34:56",                  true, 12, 34, 56 },
+        { "0:0:0",                     true,  0,  0,  0 },
+        { "4000000000:0:0",            true, 16,  0,  0 },
+        { "99999999999999999999:0:0",  true, 15,  0,  0 },
+        { "0:4294967295:4294967295",   true, 10, 43, 15 },
+        { "",                         false,  0,  0,  0 },
+        { "12:34",                    false,  0,  0,  0 },
+        { "12:34:56 ",                false,  0,  0,  0 },
+        { " 12:34:56",                false,  0,  0,  0 },
+        { ":34:56",                   false,  0,  0,  0 },
+        { "12::56",                   false,  0,  0,  0 },
+        { "12:34:",                   false,  0,  0,  0 },
+        { "1:2:3:4",                  false,  0,  0,  0 },
+        { "+1:2:3",                   false,  0,  0,  0 }
+    };
+
+    std::cout << "Time::parse( ) ... ";
+    for( const auto &test_case : test_cases ) {
+        unsigned seconds_of_day = 0;
+        const bool valid = vtsu::Time::parse( test_case.text, seconds_of_day );
+        vtsu::Time t{ test_case.text };
+        if( valid != test_case.expected_valid || t.get_seconds_of_day( ) != seconds_of_day ||
+            t.get_hours( ) != test_case.expected_hours || t.get_minutes( ) != test_case.expected_minutes ||
+            t.get_seconds( ) != test_case.expected_seconds ) {
+            throw runtime_error( message_helper( "Time::parse( ) test failed for \"" + test_case.text + "\"", __FILE__, __LINE__ ) );
+        }
+    }
+    std::cout << "OK" << endl;
+
+    // The roll_forward_* methods must not overflow for large deltas.
+    std::cout << "roll_forward_* with large deltas ... ";
+    if( vtsu::Time( "23:59:59" ).roll_forward_seconds( 4'294'967'295U ) != vtsu::Time( "06:28:14" ) ||
+        vtsu::Time( "23:59:59" ).roll_forward_minutes( 4'294'967'295U ) != vtsu::Time( "04:14:59" ) ||
+        vtsu::Time( "23:59:59" ).roll_forward_hours( 4'294'967'295U ) != vtsu::Time( "14:59:59" ) ) {
+        throw runtime_error( message_helper( "roll_forward_* overflow test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
+void test7( )
+{
+    std::cout << "parse_times( ) and format_times( ) ... ";
+    const string_view time_strings[] = { "00:00:00", "23:59:59", "bad", "7:8:9", "12:00:00" };
+    vector<vtsu::Time> times;
+    if( vtsu::parse_times( time_strings, times ) != 1 || times.size( ) != 5 ) {
+        throw runtime_error( message_helper( "parse_times( ) test failed", __FILE__, __LINE__ ) );
+    }
+
+    string text = "Times:\n";
+    vtsu::format_times( times, text );
+    if( text != "Times:\n00:00:00\n23:59:59\n00:00:00\n07:08:09\n12:00:00\n" ) {
+        throw runtime_error( message_helper( "format_times( ) test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+
+    std::cout << "to_chars( ) ... ";
+    char buffer[vtsu::time_chars];
+    auto result = vtsu::to_chars( buffer, buffer + sizeof( buffer ), vtsu::Time( 7U, 8U, 9U ) );
+    if( result.ec != errc{ } || string_view( buffer, result.ptr ) != "07:08:09" ) {
+        throw runtime_error( message_helper( "to_chars( ) test failed", __FILE__, __LINE__ ) );
+    }
+    result = vtsu::to_chars( buffer, buffer + sizeof( buffer ) - 1, vtsu::Time( 7U, 8U, 9U ) );
+    if( result.ec != errc::value_too_large ) {
+        throw runtime_error( message_helper( "to_chars( ) test failed", __FILE__, __LINE__ ) );
+    }
+    std::cout << "OK" << endl;
+}
+
+
 int main( )
 {
     try {
@@ -278,6 +361,8 @@ int main( )
         test3( );  // Tests for the roll_forward_* methods.
         test4( );  // Tests for relational operators.
         test5( );  // Tests for operator<<( )
+        test6( );  // Tests for the time string parser.
+        test7( );  // Tests for the batch operations and to_chars( ).
         return EXIT_SUCCESS;
     }
     catch ( const exception &e ) {